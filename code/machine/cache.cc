@@ -0,0 +1,103 @@
+// cache.cc
+//	Routines to simulate the tags of a set-associative cache.
+//	See cache.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cache.h"
+
+//----------------------------------------------------------------------
+// Cache::Cache
+// 	Create an empty cache of "size" bytes, split into lines of
+//	"_lineSize" bytes, "_ways" lines per set.
+//
+//	"debugName" -- name used when printing statistics
+//	"_missPenalty" -- ticks it takes to load a line
+//----------------------------------------------------------------------
+
+Cache::Cache(char *debugName, int size, int _lineSize, int _ways,
+	     int _missPenalty)
+{
+    int i;
+
+    // A reference is at most a word, and never crosses a line
+    ASSERT((_lineSize >= 4) && ((_lineSize & (_lineSize - 1)) == 0));
+    ASSERT((_ways > 0) && (_missPenalty >= 0));
+    ASSERT((size > 0) && (size % (_lineSize * _ways) == 0));
+
+    name = debugName;
+    lineSize = _lineSize;
+    ways = _ways;
+    missPenalty = _missPenalty;
+    numSets = size / (lineSize * ways);
+
+    tags = new int[numSets * ways];
+    lastUsed = new int[numSets * ways];
+    for (i = 0; i < numSets * ways; i++) {
+	tags[i] = -1;
+	lastUsed[i] = 0;
+    }
+    clock = 0;
+    hits = misses = 0;
+}
+
+//----------------------------------------------------------------------
+// Cache::~Cache
+// 	De-allocate the tag arrays.
+//----------------------------------------------------------------------
+
+Cache::~Cache()
+{
+    delete [] tags;
+    delete [] lastUsed;
+}
+
+//----------------------------------------------------------------------
+// Cache::Access
+// 	Reference the line holding physical address "physAddr".  On a
+//	miss the empty or least recently used line of its set is
+//	replaced.  Returns TRUE if the line was already cached.
+//----------------------------------------------------------------------
+
+bool
+Cache::Access(int physAddr)
+{
+    int line = physAddr / lineSize;
+    int first = (line % numSets) * ways;
+    int victim = first;
+    int i;
+
+    clock++;
+    for (i = first; i < first + ways; i++) {
+	if (tags[i] == line) {
+	    lastUsed[i] = clock;
+	    hits++;
+	    return TRUE;
+	}
+	if ((tags[victim] != -1) &&
+	    ((tags[i] == -1) || (lastUsed[i] < lastUsed[victim])))
+	    victim = i;
+    }
+    tags[victim] = line;
+    lastUsed[victim] = clock;
+    misses++;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Cache::Print
+// 	Print the geometry of the cache and how well it did.
+//----------------------------------------------------------------------
+
+void
+Cache::Print()
+{
+    printf("%s: %d bytes, %d-byte lines, %d-way, miss penalty %d: "
+	   "hits %d, misses %d, hit ratio %.4f\n", name,
+	   numSets * ways * lineSize, lineSize, ways, missPenalty,
+	   hits, misses,
+	   (hits + misses > 0) ? (float)hits/(hits + misses) : 0.0);
+}
@@ -0,0 +1,61 @@
+// cache.h
+//	Data structures for the timing model of a set-associative,
+//	physically addressed L1 cache.
+//
+//	Only the tags are simulated; the data always comes from
+//	mainMemory, so the cache changes how long a reference takes but
+//	never what it returns.  Lines are replaced LRU within a set.
+//
+//	The machine has an optional instruction cache (probed on every
+//	fetch) and an optional data cache (probed by ReadMem and
+//	WriteMem).  Each miss adds the miss penalty to the simulated
+//	time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// Which cache a reference goes to, also used to index per-thread counts
+#define ICACHE		0
+#define DCACHE		1
+#define NumCaches	2
+
+class Cache {
+  public:
+    Cache(char *debugName, int size, int lineSize, int ways, int missPenalty);
+					// size and lineSize in bytes, size
+					// a multiple of lineSize * ways
+    ~Cache();
+
+    bool Access(int physAddr);		// Look up the line holding physAddr,
+					// loading it on a miss.  TRUE on
+					// a hit
+
+    int GetMissPenalty() { return missPenalty; }
+
+    void Print();			// Print the geometry and hit ratio
+
+    int hits;				// References found in the cache
+    int misses;				// References that had to be loaded
+
+  private:
+    char *name;
+    int lineSize;			// Bytes per line
+    int numSets;			// Number of sets
+    int ways;				// Lines per set
+    int missPenalty;			// Ticks added on each miss
+
+    int *tags;				// Line number held by each line,
+					// set by set; -1 if empty
+    int *lastUsed;			// Value of "clock" at the last
+					// reference to each line
+    int clock;				// Counts references, for LRU
+};
+
+#endif // CACHE_H
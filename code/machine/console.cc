@@ -53,6 +53,7 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
     readHandler = readAvail;
     handlerArg = callArg;
     putBusy = FALSE;
+    putSize = 0;
     incoming = EOF;
 
     // start polling for incoming packets
@@ -93,11 +94,20 @@ Console::CheckCharAvail()
 			ConsoleReadInt);
 
     // do nothing if character is already buffered, or none to be read
-    if ((incoming != EOF) || !PollFile(readFileNo))
-	return;	  
-
-    // otherwise, read character and tell user about it
-    Read(readFileNo, &c, sizeof(char));
+    if (incoming != EOF)
+	return;
+    if ((inputLog != NULL) && inputLog->IsReplaying()) {
+	if (!inputLog->ReplayChar(&c))	// the keyboard is not read
+	    return;
+    } else {
+	if (!PollFile(readFileNo))
+	    return;
+	Read(readFileNo, &c, sizeof(char));
+	if (inputLog != NULL)
+	    inputLog->RecordChar(c);
+    }
+
+    // otherwise, tell user about the character
     incoming = c ;
     stats->numConsoleCharsRead++;
     (*readHandler)(handlerArg);	
@@ -114,7 +124,7 @@ void
 Console::WriteDone()
 {
     putBusy = FALSE;
-    stats->numConsoleCharsWritten++;
+    stats->numConsoleCharsWritten += putSize;
     (*writeHandler)(handlerArg);
 }
 
@@ -142,9 +152,23 @@ Console::GetChar()
 void
 Console::PutChar(char ch)
 {
-    ASSERT(putBusy == FALSE);
-    WriteFile(writeFileNo, &ch, sizeof(char));
+    PutBuffer(&ch, 1);
+}
+
+//----------------------------------------------------------------------
+// Console::PutBuffer()
+// 	Write "size" characters to the simulated display with one host
+//	write, and schedule a single interrupt for when the last of them
+//	would be out.
+//----------------------------------------------------------------------
+
+void
+Console::PutBuffer(char *buffer, int size)
+{
+    ASSERT((putBusy == FALSE) && (size > 0));
+    WriteFile(writeFileNo, buffer, size);
     putBusy = TRUE;
-    interrupt->Schedule(ConsoleWriteDone, (int)this, ConsoleTime,
+    putSize = size;
+    interrupt->Schedule(ConsoleWriteDone, (int)this, size * ConsoleTime,
 					ConsoleWriteInt);
 }
@@ -46,6 +46,10 @@ class Console {
     void PutChar(char ch);	// Write "ch" to the console display, 
 				// and return immediately.  "writeHandler" 
 				// is called when the I/O completes. 
+    void PutBuffer(char *buffer, int size);
+				// Write "size" characters at once;
+				// "writeHandler" is called once, when
+				// the last of them is out
 
     char GetChar();	   	// Poll the console input.  If a char is 
 				// available, return it.  Otherwise, return EOF.
@@ -67,6 +71,7 @@ class Console {
 					// interrupt handlers
     bool putBusy;    			// Is a PutChar operation in progress?
 					// If so, you can't do another one!
+    int putSize;			// characters being put
     char incoming;    			// Contains the character to be read,
 					// if there is one available. 
 					// Otherwise contains EOF.
@@ -157,7 +157,8 @@ Interrupt::OneTick()
         stats->totalTicks += SystemTick;
 	stats->systemTicks += SystemTick;
     } else {					// USER_PROGRAM
-	stats->totalTicks += UserTick;
+	if (scheduler->CountUserTick())		// with -cpus, only one CPU
+	    stats->totalTicks += UserTick;	// moves the clock
 	stats->userTicks += UserTick;
     }
     DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
@@ -176,6 +177,12 @@ Interrupt::OneTick()
 	currentThread->YieldCPU();
 	status = old;
     }
+    if ((old == UserMode) && scheduler->TurnIsOver()) {
+					// with -cpus, the next CPU's turn
+ 	status = SystemMode;
+	scheduler->SwitchCPU();
+	status = old;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -246,6 +253,15 @@ Interrupt::Halt()
 
     printf("Machine halting!\n\n");
     stats->Print();
+    scheduler->PrintCPUStats();
+#ifdef USER_PROGRAM
+    if (machine->icache != NULL)
+       machine->icache->Print();
+    if (machine->dcache != NULL)
+       machine->dcache->Print();
+    if (machine->pipeline != NULL)
+       machine->pipeline->Print();
+#endif
 
     if (schedulingAlgo == NON_PREEMPTIVE_SJF) {
        printf("Error in burst estimate over average burst length: %.2f\n", ((float)stats->burstEstimateError)/stats->cpu_time);
@@ -324,6 +340,60 @@ Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
     pending->SortedInsert(toOccur, when);
 }
 
+//----------------------------------------------------------------------
+// Interrupt::PendingTime
+// 	Return when the first pending interrupt of kind "type" is due,
+//	or -1 if that device has nothing scheduled.
+//----------------------------------------------------------------------
+
+int
+Interrupt::PendingTime(IntType type)
+{
+    List *kept = new List();
+    PendingInterrupt *pend;
+    int when, found = -1;
+
+    while ((pend = (PendingInterrupt *)pending->SortedRemove(&when)) != NULL) {
+	if ((found == -1) && (pend->type == type))
+	    found = when;
+	kept->SortedInsert(pend, when);
+    }
+    delete pending;
+    pending = kept;
+    return found;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Reschedule
+// 	Move the first pending interrupt of kind "type" to occur at
+//	simulated time "when" instead.  Nothing happens if the device
+//	has no interrupt pending.
+//
+//	Used when a checkpoint is restored, to put the devices of the
+//	new simulation back on the schedule of the saved one.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Reschedule(IntType type, int when)
+{
+    List *kept = new List();
+    PendingInterrupt *pend;
+    int key;
+    bool moved = FALSE;
+
+    while ((pend = (PendingInterrupt *)pending->SortedRemove(&key)) != NULL) {
+	if (!moved && (pend->type == type)) {
+	    DEBUG('i', "Rescheduling the %s from %d to %d\n",
+		  intTypeNames[type], key, when);
+	    pend->when = key = when;
+	    moved = TRUE;
+	}
+	kept->SortedInsert(pend, key);
+    }
+    delete pending;
+    pending = kept;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::CheckIfDue
 // 	Check if an interrupt is scheduled to occur, and if so, fire it off.
@@ -99,6 +99,13 @@ class Interrupt {
     void setStatus(MachineStatus st) { status = st; }
 
     void DumpState();			// Print interrupt state
+
+    int PendingTime(IntType type);	// When the first pending interrupt
+					// of this type is due, -1 if none
+    void Reschedule(IntType type, int when);
+					// Move the first pending interrupt
+					// of this type to time "when".
+					// Used by checkpoint restore
     
 
     // NOTE: the following are internal to the hardware simulation code.
@@ -44,6 +44,41 @@ void CheckEndian()
 #endif
 }
 
+SimulationLocal int pageSize = DefaultPageSize;
+SimulationLocal int numPhysPages = DefaultNumPhysPages;
+
+//----------------------------------------------------------------------
+// SetPageSize
+// 	Change the page size, before the machine is created.  Physical
+//	memory keeps its size, so the number of frames changes.
+//----------------------------------------------------------------------
+
+void
+SetPageSize(int size)
+{
+    ASSERT(size >= 16 && (size & (size - 1)) == 0);	// a power of two
+    ASSERT(size <= DefaultNumPhysPages * DefaultPageSize / (2 * LargePageFactor));
+    pageSize = size;
+    numPhysPages = (DefaultNumPhysPages * DefaultPageSize) / size;
+}
+
+SimulationLocal int tlbSize = TLBSize;
+SimulationLocal int tlbWays = TLBWays;
+
+//----------------------------------------------------------------------
+// SetTLBGeometry
+// 	Change the number of TLB entries and their associativity,
+//	before the machine is created.
+//----------------------------------------------------------------------
+
+void
+SetTLBGeometry(int size, int ways)
+{
+    ASSERT((size > 0) && (ways > 0) && (size % ways == 0));
+    tlbSize = size;
+    tlbWays = ways;
+}
+
 //----------------------------------------------------------------------
 // Machine::Machine
 // 	Initialize the simulation of user program execution.
@@ -64,7 +99,10 @@ Machine::Machine(bool debug)
     virtualPageNo = new int[NumPhysPages];
     referenceBit = new bool[NumPhysPages];
     isShared = new bool[NumPhysPages];
+    isLocked = new bool[NumPhysPages];
+    numLockedPages = 0;
     LRUTimeStamp = new long long int[NumPhysPages];
+    linkAddress = -1;
 
     for (i = 0; i < MemorySize; i++)
         mainMemory[i] = 0;
@@ -74,19 +112,40 @@ Machine::Machine(bool debug)
         virtualPageNo[i] = -1;
         referenceBit[i] = 0;
         isShared[i] = 0;
+        isLocked[i] = 0;
         LRUTimeStamp[i] = 0;
     }
 
 
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-	tlb[i].valid = FALSE;
+    numTLBs = numCPUs;			// one TLB per CPU
+    cpuTLB = new TranslationEntry*[numTLBs];
+    cpuTLBLastUsed = new int*[numTLBs];
+    for (int c = 0; c < numTLBs; c++) {
+	cpuTLB[c] = new TranslationEntry[tlbSize];
+	cpuTLBLastUsed[c] = new int[tlbSize];
+	for (i = 0; i < tlbSize; i++) {
+	    cpuTLB[c][i].valid = FALSE;
+	    cpuTLBLastUsed[c][i] = 0;
+	}
+    }
+    SelectTLB(0);
     NachOSpageTable = NULL;
 #else	// use linear page table
+    numTLBs = 0;
+    cpuTLB = NULL;
+    cpuTLBLastUsed = NULL;
     tlb = NULL;
+    tlbLastUsed = NULL;
     NachOSpageTable = NULL;
 #endif
+    currentASID = -1;
+    icache = dcache = NULL;
+    pipeline = NULL;
+    stackPageTable = NULL;
+    stackPageTableSize = 0;
+    stackPageTableTop = 0;
+    pageDirectory = NULL;
 
     singleStep = debug;
     CheckEndian();
@@ -103,10 +162,37 @@ Machine::~Machine()
     delete [] memoryUsedBy;
     delete [] virtualPageNo;
     delete [] isShared;
+    delete [] isLocked;
     delete [] referenceBit;
     delete [] LRUTimeStamp;
-    if (tlb != NULL)
-        delete [] tlb;
+    if (icache != NULL)
+        delete icache;
+    if (dcache != NULL)
+        delete dcache;
+    if (pipeline != NULL)
+        delete pipeline;
+    for (int c = 0; c < numTLBs; c++) {
+        delete [] cpuTLB[c];
+        delete [] cpuTLBLastUsed[c];
+    }
+    if (cpuTLB != NULL) {
+        delete [] cpuTLB;
+        delete [] cpuTLBLastUsed;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::SelectTLB
+// 	Make the TLB of CPU "cpu" the one that translates addresses.
+//	Called when that CPU gets its turn (see NachOSscheduler).
+//----------------------------------------------------------------------
+
+void
+Machine::SelectTLB(int cpu)
+{
+    ASSERT((cpu >= 0) && (cpu < numTLBs));
+    tlb = cpuTLB[cpu];
+    tlbLastUsed = cpuTLBLastUsed[cpu];
 }
 
 //----------------------------------------------------------------------
@@ -213,6 +299,10 @@ Machine::DumpState()
     printf("\tPrevPC:\t0x%x\n", registers[PrevPCReg]);
     printf("\tLoad:\t0x%x", registers[LoadReg]);
     printf("\tLoadV:\t0x%x\n", registers[LoadValueReg]);
+    for (i = 0; i < NumFPRegs; i++)
+	printf("\tf%d:\t0x%x%s", i, registers[FirstFPReg + i],
+	       ((i % 4) == 3) ? "\n" : "");
+    printf("\tFCSR:\t0x%x\n", registers[FCSRReg]);
     printf("\n");
 }
 
@@ -24,18 +24,52 @@
 #include "copyright.h"
 #include "utility.h"
 #include "translate.h"
+#include "pagetable.h"
+#include "cache.h"
+#include "pipeline.h"
 #include "disk.h"
 
 // Definitions related to the size, and format of user memory
 
-#define PageSize 	SectorSize 	// set the page size equal to
+#define DefaultPageSize	SectorSize 	// set the page size equal to
 					// the disk sector size, for
 					// simplicity
 
-//#define NumPhysPages    32
-#define NumPhysPages    1024
+//#define DefaultNumPhysPages    32
+#define DefaultNumPhysPages    1024
+
+// The page size can be changed with -ps.  The amount of physical
+// memory stays DefaultNumPhysPages * DefaultPageSize bytes, so a
+// bigger page means fewer frames.
+
+extern SimulationLocal int pageSize;			// bytes per page
+extern SimulationLocal int numPhysPages;		// frames of physical memory
+
+#define PageSize	pageSize
+#define NumPhysPages	numPhysPages
 #define MemorySize 	(NumPhysPages * PageSize)
+
+// A large page is LargePageFactor consecutive, aligned pages mapped
+// by the single translation entry of its first page (see
+// Machine::Translate).  Its frames are consecutive too.
+
+#define LargePageFactor	8
+
+// LL links the CPU to the line of physical memory it loads from, and
+// SC stores only if the link still holds.  A store by anyone to that
+// line, a context switch, or handing the frame to another page breaks
+// the link.
+
+#define LinkLineSize	16		// bytes watched by a link
 #define TLBSize		4		// if there is a TLB, make it small
+#define TLBWays		TLBSize		// and fully associative
+
+// The TLB geometry can be changed with -tlb and -tlbways.  A TLB of
+// tlbSize entries is split into tlbSize/tlbWays sets; virtual page
+// vpn can only live in set (vpn % number of sets).
+
+extern SimulationLocal int tlbSize;			// entries in the TLB
+extern SimulationLocal int tlbWays;			// entries per set
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -69,8 +103,17 @@ enum ExceptionType { NoException,           // Everything ok!
 #define LoadReg		37	// The register target of a delayed load.
 #define LoadValueReg 	38	// The value to be loaded by a delayed load.
 #define BadVAddrReg	39	// The failing virtual address on an exception
+#define FirstFPReg	40	// Floating point registers f0..f31 of the
+				// coprocessor; a double is held in an
+				// even/odd pair, low word in the even one
+#define FCSRReg		72	// FP control/status: rounding mode and
+				// the compare condition bit
+
+#define NumFPRegs	32
+#define NumTotalRegs 	73
 
-#define NumTotalRegs 	40
+#define FPCondBit	0x00800000	// set by C.cond.fmt, tested by BC1T/F
+#define FPRoundMask	0x3		// rounding mode of CVT.W.fmt
 
 // The following class defines an instruction, represented in both
 // 	undecoded binary form
@@ -96,7 +139,8 @@ class Instruction {
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our
 // simulator or on the real hardware, except
-//	we don't support floating point instructions
+//	we don't raise floating point exceptions (results are whatever
+//	  the host computes, e.g. infinities on division by zero)
 //	the system call interface to Nachos is not the same as UNIX
 //	  (10 system calls in Nachos vs. 200 in UNIX!)
 // If we were to implement more of the UNIX system calls, we ought to be
@@ -127,11 +171,31 @@ class Machine {
     void DelayedLoad(int nextReg, int nextVal);
 				// Do a pending delayed load (modifying a reg)
 
+    double ReadFP(int fmt, int reg);
+    void WriteFP(int fmt, int reg, double value);
+				// Read or write FP register "reg" as a
+				// single, a double (in the even/odd pair
+				// from "reg") or a word, as "fmt" says
+
     bool ReadMem(int addr, int size, int* value);
     bool WriteMem(int addr, int size, int value);
     				// Read or write 1, 2, or 4 bytes of virtual
 				// memory (at addr).  Return FALSE if a
 				// correct translation couldn't be found.
+    bool FetchInstruction(int addr, int* value);
+				// Read the instruction word at addr,
+				// through the instruction cache
+    bool LoadLinked(int addr, int* value);
+				// LL: ReadMem a word, and link to it
+    bool StoreConditional(int addr, int value, bool* stored);
+				// SC: WriteMem a word if still linked;
+				// "stored" says if it was.  Returns FALSE
+				// on an exception, like WriteMem
+
+    void BreakLink() { linkAddress = -1; }
+				// On a context switch
+    void BreakLinkToFrame(int frame);
+				// The frame now holds another page
 
 
     ExceptionType Translate(int virtAddr, int* physAddr, int size,bool writing);
@@ -168,11 +232,17 @@ class Machine {
     bool *referenceBit;         // reference bit, used by page replacement
                                 // algorithm: LRU_CLOCK_REPL
     bool *isShared;             // Is this physpage marked as shared?
+    bool *isLocked;             // Is this physpage pinned (MADV_LOCK
+                                // or part of a large page)?
+    int numLockedPages;         // How many physpages are pinned
 
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
     long long int* LRUTimeStamp; // Stores time of last access
 
+    int linkAddress;		// physical address linked by LL, -1 if
+				// there is no link
+
 // NOTE: the hardware translation of virtual addresses in the user program
 // to physical addresses (relative to the beginning of "mainMemory")
 // can be controlled by one of:
@@ -194,16 +264,77 @@ class Machine {
     TranslationEntry *tlb;		// this pointer should be considered
 					// "read-only" to Nachos kernel code
 
+// Each TLB entry is tagged with the address space ID (asid) of the
+// space that loaded it, and only matches while that space is current,
+// so a context switch does not have to flush the TLB.  The hardware
+// also records when each entry was last used, for the kernel's
+// replacement policy.
+
+    int currentASID;			// set by the kernel on a switch
+    int *tlbLastUsed;			// tick of the last hit per entry
+
+// With several CPUs (-cpus) each has its own TLB; "tlb" points to
+// the one of the CPU whose turn it is.
+
+    int numTLBs;
+    TranslationEntry **cpuTLB;		// TLB of each CPU
+    int **cpuTLBLastUsed;
+
+    void SelectTLB(int cpu);		// switch to cpu's TLB
+
+    int TLBLookup(unsigned vpn);	// index of the entry mapping vpn
+					// for currentASID, or -1
+    int TLBSetOf(unsigned vpn);		// first entry of vpn's set
+
     TranslationEntry *NachOSpageTable;
     unsigned int NachOSpageTableSize;
 
+// A second, downward growing page table maps the user stack.  Entry i
+// holds virtual page (stackPageTableTop - 1 - i), so the stack can grow
+// without touching the table for the low part of the address space.
+// Pages between the two tables fault, and the kernel decides whether
+// that is stack growth or a bad address.
+
+    TranslationEntry *stackPageTable;
+    unsigned int stackPageTableSize;
+    unsigned int stackPageTableTop;	// first virtual page above the stack
+
+// With a two-level page table (-T 1) every page is looked up in
+// "pageDirectory" instead, and the two flat tables are NULL.
+
+    TwoLevelPageTable *pageDirectory;
+
+    TranslationEntry *PageTableLookup(unsigned vpn);
+				// The page table entry for vpn, or NULL
+				// if neither table maps it
+
+// Optional L1 caches (-icache, -dcache), NULL if not modelled.  They
+// only affect timing: a miss adds the cache's penalty to totalTicks.
+
+    Cache *icache;
+    Cache *dcache;
+
+// Optional pipeline cycle model (-pipe), NULL if every instruction
+// takes UserTick.  Its stalls are added to totalTicks as well.
+
+    PipelineModel *pipeline;
+
   private:
+    void CacheReference(int which, int physAddr);
+				// Probe icache or dcache, charging a miss
+
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
 				// time reaches this value
 };
 
+extern void SetPageSize(int size);	// Called for -ps, before the
+					// Machine is created
+extern void SetTLBGeometry(int size, int ways);
+					// Called for -tlb/-tlbways, before
+					// the Machine is created
+
 extern void ExceptionHandler(ExceptionType which);
 				// Entry point into Nachos for handling
 				// user system calls and exceptions
@@ -16,7 +16,18 @@
 #include "mipssim.h"
 #include "system.h"
 
+// Host floating point, for the coprocessor
+extern "C" {
+double sqrt(double x);
+double fabs(double x);
+double ceil(double x);
+double floor(double x);
+double rint(double x);
+}
+
 static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
+static int RoundToWord(double value, int mode);
+static bool Compare(double a, double b, int cond);
 
 //----------------------------------------------------------------------
 // Machine::Run
@@ -100,7 +111,7 @@ Machine::OneInstruction(Instruction *instr)
 				// in the future
 
     // Fetch instruction 
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
+    if (!machine->FetchInstruction(registers[PCReg], &raw))
 	return;			// exception occurred
     instr->value = raw;
     instr->Decode();
@@ -118,6 +129,8 @@ Machine::OneInstruction(Instruction *instr)
     // Compute next pc, but don't install in case there's an error or branch.
     int pcAfter = registers[NextPCReg] + 4;
     int sum, diff, tmp, value;
+    bool stored;
+    double fs, ft, fd;
     unsigned int rs, rt, imm;
 
     // Execute the instruction (cf. Kane's book)
@@ -277,6 +290,18 @@ Machine::OneInstruction(Instruction *instr)
 	nextLoadReg = instr->rt;
 	nextLoadValue = value;
 	break;
+
+      case OP_LL:
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (!machine->LoadLinked(tmp, &value))
+	    return;
+	nextLoadReg = instr->rt;
+	nextLoadValue = value;
+	break;
     	
       case OP_LWL:	  
 	tmp = registers[instr->rs] + instr->extra;
@@ -475,6 +500,17 @@ Machine::OneInstruction(Instruction *instr)
 	    return;
 	break;
 	
+      case OP_SC:
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (!machine->StoreConditional(tmp, registers[instr->rt], &stored))
+	    return;
+	registers[instr->rt] = stored ? 1 : 0;
+	break;
+
       case OP_SWL:	  
 	tmp = registers[instr->rs] + instr->extra;
 
@@ -544,6 +580,145 @@ Machine::OneInstruction(Instruction *instr)
 	registers[instr->rt] = registers[instr->rs] ^ (instr->extra & 0xffff);
 	break;
 	
+      case OP_LWC1:
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (!machine->ReadMem(tmp, 4, &value))
+	    return;
+	nextLoadReg = FirstFPReg + instr->rt;
+	nextLoadValue = value;
+	break;
+
+      case OP_SWC1:
+	if (!machine->WriteMem((unsigned)
+		(registers[instr->rs] + instr->extra), 4,
+		registers[FirstFPReg + instr->rt]))
+	    return;
+	break;
+
+      case OP_LDC1:
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x7) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (!machine->ReadMem(tmp, 4, &value))
+	    return;
+	if (!machine->ReadMem(tmp + 4, 4, &sum))
+	    return;
+	registers[FirstFPReg + (instr->rt & ~1)] = value;
+	registers[FirstFPReg + (instr->rt | 1)] = sum;
+	break;
+
+      case OP_SDC1:
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x7) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (!machine->WriteMem(tmp, 4, registers[FirstFPReg + (instr->rt & ~1)]))
+	    return;
+	if (!machine->WriteMem(tmp + 4, 4, registers[FirstFPReg + (instr->rt | 1)]))
+	    return;
+	break;
+
+      case OP_MFC1:
+	nextLoadReg = instr->rt;
+	nextLoadValue = registers[FirstFPReg + instr->rd];
+	break;
+
+      case OP_MTC1:
+	registers[FirstFPReg + instr->rd] = registers[instr->rt];
+	break;
+
+      case OP_CFC1:			// only the control/status register
+	nextLoadReg = instr->rt;	// (31) is implemented
+	nextLoadValue = (instr->rd == 31) ? registers[FCSRReg] : 0;
+	break;
+
+      case OP_CTC1:
+	if (instr->rd == 31)
+	    registers[FCSRReg] = registers[instr->rt];
+	break;
+
+      case OP_BC1F:
+	if (!(registers[FCSRReg] & FPCondBit))
+	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+	break;
+
+      case OP_BC1T:
+	if (registers[FCSRReg] & FPCondBit)
+	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+	break;
+
+      case OP_FADD:
+      case OP_FSUB:
+      case OP_FMUL:
+      case OP_FDIV:
+	// A single computed in double and rounded once is exact
+	fs = ReadFP(instr->rs, instr->rd);
+	ft = ReadFP(instr->rs, instr->rt);
+	if (instr->opCode == OP_FADD)
+	    fd = fs + ft;
+	else if (instr->opCode == OP_FSUB)
+	    fd = fs - ft;
+	else if (instr->opCode == OP_FMUL)
+	    fd = fs * ft;
+	else
+	    fd = fs / ft;
+	WriteFP(instr->rs, instr->extra, fd);
+	break;
+
+      case OP_FSQRT:
+	WriteFP(instr->rs, instr->extra, sqrt(ReadFP(instr->rs, instr->rd)));
+	break;
+
+      case OP_FABS:
+	WriteFP(instr->rs, instr->extra, fabs(ReadFP(instr->rs, instr->rd)));
+	break;
+
+      case OP_FMOV:
+	WriteFP(instr->rs, instr->extra, ReadFP(instr->rs, instr->rd));
+	break;
+
+      case OP_FNEG:
+	WriteFP(instr->rs, instr->extra, -ReadFP(instr->rs, instr->rd));
+	break;
+
+      case OP_ROUNDW:
+      case OP_TRUNCW:
+      case OP_CEILW:
+      case OP_FLOORW:
+	// in the same order as the rounding modes
+	registers[FirstFPReg + instr->extra] =
+	    RoundToWord(ReadFP(instr->rs, instr->rd), instr->opCode - OP_ROUNDW);
+	break;
+
+      case OP_CVTW:
+	registers[FirstFPReg + instr->extra] =
+	    RoundToWord(ReadFP(instr->rs, instr->rd),
+			registers[FCSRReg] & FPRoundMask);
+	break;
+
+      case OP_CVTS:
+	WriteFP(FMT_S, instr->extra, ReadFP(instr->rs, instr->rd));
+	break;
+
+      case OP_CVTD:
+	WriteFP(FMT_D, instr->extra, ReadFP(instr->rs, instr->rd));
+	break;
+
+      case OP_FCMP:
+	if (Compare(ReadFP(instr->rs, instr->rd), ReadFP(instr->rs, instr->rt),
+		    instr->extra))
+	    registers[FCSRReg] |= FPCondBit;
+	else
+	    registers[FCSRReg] &= ~FPCondBit;
+	break;
+
       case OP_RES:
       case OP_UNIMP:
 	RaiseException(IllegalInstrException, 0);
@@ -555,6 +730,15 @@ Machine::OneInstruction(Instruction *instr)
     
     // Now we have successfully executed the instruction.
     
+    // Charge the pipeline stalls it caused, if they are modelled
+    if (pipeline != NULL) {
+	int stalls = pipeline->Stalls(instr, registers[PCReg],
+				      pcAfter != registers[NextPCReg] + 4);
+	if (scheduler->MovesClock())	// with -cpus, only one CPU
+	    stats->totalTicks += stalls;	// moves the clock
+	stats->pipelineStallTicks += stalls;
+    }
+
     // Do any delayed load operation
     DelayedLoad(nextLoadReg, nextLoadValue);
     
@@ -609,6 +793,45 @@ Instruction::Decode()
     }
     if (opCode == SPECIAL) {
 	opCode = specialTable[value & 0x3f];
+    } else if (opCode == COP1) {
+	switch (rs) {
+	  case 0:
+	    opCode = OP_MFC1;
+	    break;
+	  case 2:
+	    opCode = OP_CFC1;
+	    break;
+	  case 4:
+	    opCode = OP_MTC1;
+	    break;
+	  case 6:
+	    opCode = OP_CTC1;
+	    break;
+	  case 8:
+	    opCode = (rt & 1) ? OP_BC1T : OP_BC1F;
+	    extra = value & 0xffff;
+	    if (extra & 0x8000) {
+		extra |= 0xffff0000;
+	    }
+	    break;
+	  case FMT_S:
+	  case FMT_D:
+	  case FMT_W:
+	    opCode = cop1Table[value & 0x3f];
+	    if (opCode == OP_FCMP) {
+		extra = value & 0xf;
+	    }
+	    // a word can only be converted; nothing converts to itself
+	    if (((rs == FMT_W) && (opCode != OP_CVTS) && (opCode != OP_CVTD)) ||
+		((rs == FMT_S) && (opCode == OP_CVTS)) ||
+		((rs == FMT_D) && (opCode == OP_CVTD))) {
+		opCode = OP_RES;
+	    }
+	    break;
+	  default:
+	    opCode = OP_UNIMP;
+	    break;
+	}
     } else if (opCode == BCOND) {
 	int i = value & 0x1f0000;
 
@@ -691,3 +914,97 @@ Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr)
     *hiPtr = (int) hi;
     *loPtr = (int) lo;
 }
+
+//----------------------------------------------------------------------
+// Machine::ReadFP, Machine::WriteFP
+// 	Read or write floating point register "reg" in the format "fmt"
+//	(FMT_S, FMT_D or FMT_W).  A double takes the even/odd pair that
+//	"reg" falls in, low word first, as on a little-endian R3010.
+//----------------------------------------------------------------------
+
+double
+Machine::ReadFP(int fmt, int reg)
+{
+    float single;
+    unsigned int words[2];
+    double d;
+
+    switch (fmt) {
+      case FMT_S:
+	bcopy(&registers[FirstFPReg + reg], &single, sizeof(single));
+	return single;
+      case FMT_D:
+	words[0] = registers[FirstFPReg + (reg & ~1)];
+	words[1] = registers[FirstFPReg + (reg | 1)];
+	bcopy(words, &d, sizeof(d));
+	return d;
+      default:
+	return registers[FirstFPReg + reg];
+    }
+}
+
+void
+Machine::WriteFP(int fmt, int reg, double value)
+{
+    float single;
+    unsigned int words[2];
+
+    switch (fmt) {
+      case FMT_S:
+	single = (float) value;
+	bcopy(&single, &registers[FirstFPReg + reg], sizeof(single));
+	break;
+      case FMT_D:
+	bcopy(&value, words, sizeof(value));
+	registers[FirstFPReg + (reg & ~1)] = words[0];
+	registers[FirstFPReg + (reg | 1)] = words[1];
+	break;
+      default:
+	registers[FirstFPReg + reg] = (int) value;
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// RoundToWord
+// 	Convert a floating point value to a word, rounding it to the
+//	nearest (mode 0), toward zero (1), up (2) or down (3).  A value
+//	that does not fit gives the largest word, as the R3010 does.
+//----------------------------------------------------------------------
+
+static int
+RoundToWord(double value, int mode)
+{
+    switch (mode) {
+      case 0:
+	value = rint(value);
+	break;
+      case 1:
+	value = (value < 0) ? ceil(value) : floor(value);
+	break;
+      case 2:
+	value = ceil(value);
+	break;
+      default:
+	value = floor(value);
+	break;
+    }
+    if ((value != value) || (value > 2147483647.0) || (value < -2147483648.0))
+	return 0x7fffffff;
+    return (int) value;
+}
+
+//----------------------------------------------------------------------
+// Compare
+// 	The outcome of C.cond.fmt.  The low three bits of "cond" ask for
+//	less than, equal, and unordered (a NaN on either side); the
+//	condition holds if any of the outcomes asked for is true.
+//----------------------------------------------------------------------
+
+static bool
+Compare(double a, double b, int cond)
+{
+    if ((a != a) || (b != b))
+	return (cond & 0x1) != 0;
+    return (((cond & 0x2) && (a == b)) || ((cond & 0x4) && (a < b)));
+}
@@ -85,7 +85,46 @@
 #define OP_SYSCALL	61
 #define OP_UNIMP	62
 #define OP_RES		63
-#define MaxOpcode	63
+#define OP_LL		64
+#define OP_SC		65
+
+/*
+ * Coprocessor 1 (floating point).  Arithmetic is decoded with
+ * rs = fmt, rt = ft, rd = fs and extra = fd (or the condition,
+ * for a compare).
+ */
+
+#define OP_LWC1		66
+#define OP_SWC1		67
+#define OP_LDC1		68
+#define OP_SDC1		69
+#define OP_MFC1		70
+#define OP_MTC1		71
+#define OP_CFC1		72
+#define OP_CTC1		73
+#define OP_BC1F		74
+#define OP_BC1T		75
+#define OP_FADD		76
+#define OP_FSUB		77
+#define OP_FMUL		78
+#define OP_FDIV		79
+#define OP_FSQRT	80
+#define OP_FABS		81
+#define OP_FMOV		82
+#define OP_FNEG		83
+#define OP_ROUNDW	84
+#define OP_TRUNCW	85
+#define OP_CEILW	86
+#define OP_FLOORW	87
+#define OP_CVTS		88
+#define OP_CVTD		89
+#define OP_CVTW		90
+#define OP_FCMP		91
+#define MaxOpcode	91
+
+#define FMT_S		16	/* fmt field: single, double, word */
+#define FMT_D		17
+#define FMT_W		20
 
 /*
  * Miscellaneous definitions:
@@ -104,6 +143,7 @@
 
 #define SPECIAL 100
 #define BCOND	101
+#define COP1	102
 
 #define IFMT 1
 #define JFMT 2
@@ -119,7 +159,7 @@ static OpInfo opTable[] = {
     {OP_BEQ, IFMT}, {OP_BNE, IFMT}, {OP_BLEZ, IFMT}, {OP_BGTZ, IFMT},
     {OP_ADDI, IFMT}, {OP_ADDIU, IFMT}, {OP_SLTI, IFMT}, {OP_SLTIU, IFMT},
     {OP_ANDI, IFMT}, {OP_ORI, IFMT}, {OP_XORI, IFMT}, {OP_LUI, IFMT},
-    {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
+    {OP_UNIMP, IFMT}, {COP1, RFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
     {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
     {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
     {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
@@ -127,10 +167,10 @@ static OpInfo opTable[] = {
     {OP_LBU, IFMT}, {OP_LHU, IFMT}, {OP_LWR, IFMT}, {OP_RES, IFMT},
     {OP_SB, IFMT}, {OP_SH, IFMT}, {OP_SWL, IFMT}, {OP_SW, IFMT},
     {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_SWR, IFMT}, {OP_RES, IFMT},
-    {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
-    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
-    {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
-    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}
+    {OP_LL, IFMT}, {OP_LWC1, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
+    {OP_RES, IFMT}, {OP_LDC1, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_SC, IFMT}, {OP_SWC1, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
+    {OP_RES, IFMT}, {OP_SDC1, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}
 };
 
 /*
@@ -149,6 +189,22 @@ static int specialTable[] = {
     OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES
 };
 
+/*
+ * The table below is used to convert the "funct" field of COP1
+ * arithmetic instructions (fmt S, D or W) into the "opCode" field.
+ */
+
+static int cop1Table[] = {
+    OP_FADD, OP_FSUB, OP_FMUL, OP_FDIV, OP_FSQRT, OP_FABS, OP_FMOV, OP_FNEG,
+    OP_RES, OP_RES, OP_RES, OP_RES, OP_ROUNDW, OP_TRUNCW, OP_CEILW, OP_FLOORW,
+    OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_CVTS, OP_CVTD, OP_RES, OP_RES, OP_CVTW, OP_RES, OP_RES, OP_RES,
+    OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_FCMP, OP_FCMP, OP_FCMP, OP_FCMP, OP_FCMP, OP_FCMP, OP_FCMP, OP_FCMP,
+    OP_FCMP, OP_FCMP, OP_FCMP, OP_FCMP, OP_FCMP, OP_FCMP, OP_FCMP, OP_FCMP
+};
+
 
 // Stuff to help print out each instruction, for debugging
 
@@ -223,7 +279,35 @@ static struct OpString opStrings[] = {
 	{"XORI r%d,r%d,%d", {RT, RS, EXTRA}},
 	{"SYSCALL", {NONE, NONE, NONE}},
 	{"Unimplemented", {NONE, NONE, NONE}},
-	{"Reserved", {NONE, NONE, NONE}}
+	{"Reserved", {NONE, NONE, NONE}},
+	{"LL r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"SC r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LWC1 f%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"SWC1 f%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LDC1 f%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"SDC1 f%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"MFC1 r%d,f%d", {RT, RD, NONE}},
+	{"MTC1 r%d,f%d", {RT, RD, NONE}},
+	{"CFC1 r%d,%d", {RT, RD, NONE}},
+	{"CTC1 r%d,%d", {RT, RD, NONE}},
+	{"BC1F %d", {EXTRA, NONE, NONE}},
+	{"BC1T %d", {EXTRA, NONE, NONE}},
+	{"ADD.fmt f%d,f%d,f%d", {EXTRA, RD, RT}},
+	{"SUB.fmt f%d,f%d,f%d", {EXTRA, RD, RT}},
+	{"MUL.fmt f%d,f%d,f%d", {EXTRA, RD, RT}},
+	{"DIV.fmt f%d,f%d,f%d", {EXTRA, RD, RT}},
+	{"SQRT.fmt f%d,f%d", {EXTRA, RD, NONE}},
+	{"ABS.fmt f%d,f%d", {EXTRA, RD, NONE}},
+	{"MOV.fmt f%d,f%d", {EXTRA, RD, NONE}},
+	{"NEG.fmt f%d,f%d", {EXTRA, RD, NONE}},
+	{"ROUND.W.fmt f%d,f%d", {EXTRA, RD, NONE}},
+	{"TRUNC.W.fmt f%d,f%d", {EXTRA, RD, NONE}},
+	{"CEIL.W.fmt f%d,f%d", {EXTRA, RD, NONE}},
+	{"FLOOR.W.fmt f%d,f%d", {EXTRA, RD, NONE}},
+	{"CVT.S.fmt f%d,f%d", {EXTRA, RD, NONE}},
+	{"CVT.D.fmt f%d,f%d", {EXTRA, RD, NONE}},
+	{"CVT.W.fmt f%d,f%d", {EXTRA, RD, NONE}},
+	{"C.%d.fmt f%d,f%d", {EXTRA, RD, RT}}
       };
 
 #endif // MIPSSIM_H
@@ -36,10 +36,14 @@ Network::Network(NetworkAddress addr, double reliability,
     sendBusy = FALSE;
     inHdr.length = 0;
     
-    sock = OpenSocket();
     sprintf(sockName, "SOCKET_%d", (int)addr);
-    AssignNameToSocket(sockName, sock);		 // Bind socket to a filename 
+    if ((inputLog != NULL) && inputLog->IsReplaying())
+	sock = -1;				 // packets come from the log
+    else {
+	sock = OpenSocket();
+	AssignNameToSocket(sockName, sock);	 // Bind socket to a filename 
 						 // in the current directory.
+    }
 
     // start polling for incoming packets
     interrupt->Schedule(NetworkReadPoll, (int)this, NetworkTime, NetworkRecvInt);
@@ -47,6 +51,8 @@ Network::Network(NetworkAddress addr, double reliability,
 
 Network::~Network()
 {
+    if (sock == -1)
+	return;
     CloseSocket(sock);
     DeAssignNameToSocket(sockName);
 }
@@ -62,12 +68,25 @@ Network::CheckPktAvail()
 
     if (inHdr.length != 0) 	// do nothing if packet is already buffered
 	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
-	return;
 
-    // otherwise, read packet in
     char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
+    if (sock == -1) {		// replaying: is a packet due?
+	if (inputLog->ReplayPacket(buffer, MaxWireSize) == 0) {
+	    delete []buffer;
+	    return;
+	}
+    } else {
+	if (!PollSocket(sock)) {	// do nothing if no packet to be read
+	    delete []buffer;
+	    return;
+	}
+
+	// otherwise, read packet in
+	ReadFromSocket(sock, buffer, MaxWireSize);
+	if (inputLog != NULL)	// only the header and the data
+	    inputLog->RecordPacket(buffer, sizeof(PacketHeader) +
+				   ((PacketHeader *)buffer)->length);
+    }
 
     // divide packet into header and data
     inHdr = *(PacketHeader *)buffer;
@@ -119,7 +138,8 @@ Network::Send(PacketHeader hdr, char* data)
     char *buffer = new char[MaxWireSize];
     *(PacketHeader *)buffer = hdr;
     bcopy(data, buffer + sizeof(PacketHeader), hdr.length);
-    SendToSocket(sock, buffer, MaxWireSize, toName);
+    if (sock != -1)		// a replay sends nothing
+	SendToSocket(sock, buffer, MaxWireSize, toName);
     delete []buffer;
 }
 
@@ -0,0 +1,102 @@
+// pagetable.cc
+//	Routines to manage a two-level page table.  See pagetable.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pagetable.h"
+
+//----------------------------------------------------------------------
+// TwoLevelPageTable::TwoLevelPageTable
+// 	Create an empty page table able to map virtual pages
+//	0 .. maxPages-1.  Only the directory is allocated.
+//----------------------------------------------------------------------
+
+TwoLevelPageTable::TwoLevelPageTable(unsigned maxPages)
+{
+    unsigned i;
+
+    directorySize = divRoundUp(maxPages, PageTableChunkSize);
+    directory = new TranslationEntry*[directorySize];
+    for (i = 0; i < directorySize; i++)
+        directory[i] = NULL;
+    numChunks = 0;
+}
+
+//----------------------------------------------------------------------
+// TwoLevelPageTable::~TwoLevelPageTable
+// 	Free the directory and every chunk.
+//----------------------------------------------------------------------
+
+TwoLevelPageTable::~TwoLevelPageTable()
+{
+    unsigned i;
+
+    for (i = 0; i < directorySize; i++) {
+        if (directory[i] != NULL)
+            delete [] directory[i];
+    }
+    delete [] directory;
+}
+
+//----------------------------------------------------------------------
+// TwoLevelPageTable::Lookup
+// 	Return the entry for "vpn", or NULL if it was never mapped.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+TwoLevelPageTable::Lookup(unsigned vpn)
+{
+    unsigned chunk = vpn / PageTableChunkSize;
+    unsigned index = vpn % PageTableChunkSize;
+
+    if ((chunk >= directorySize) || (directory[chunk] == NULL)
+        || (directory[chunk][index].virtualPage != (int) vpn))
+        return NULL;
+    return &directory[chunk][index];
+}
+
+//----------------------------------------------------------------------
+// TwoLevelPageTable::Map
+// 	Return the entry for "vpn", marking it mapped.  Its chunk is
+//	allocated on first use; no existing entry moves.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+TwoLevelPageTable::Map(unsigned vpn)
+{
+    unsigned chunk = vpn / PageTableChunkSize;
+    unsigned index = vpn % PageTableChunkSize;
+    unsigned i;
+
+    ASSERT(chunk < directorySize);
+    if (directory[chunk] == NULL) {
+        directory[chunk] = new TranslationEntry[PageTableChunkSize];
+        for (i = 0; i < PageTableChunkSize; i++)
+            directory[chunk][i].virtualPage = -1;
+        numChunks++;
+    }
+    directory[chunk][index].virtualPage = vpn;
+    return &directory[chunk][index];
+}
+
+bool
+TwoLevelPageTable::IsMapped(unsigned vpn)
+{
+    return (Lookup(vpn) != NULL);
+}
+
+//----------------------------------------------------------------------
+// TwoLevelPageTable::GetTableBytes
+// 	Host memory taken by the directory and the chunks, to compare
+//	against a flat table of sizeof(TranslationEntry) per page.
+//----------------------------------------------------------------------
+
+unsigned
+TwoLevelPageTable::GetTableBytes()
+{
+    return directorySize * sizeof(TranslationEntry *)
+        + numChunks * PageTableChunkSize * sizeof(TranslationEntry);
+}
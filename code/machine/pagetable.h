@@ -0,0 +1,50 @@
+// pagetable.h
+//	Data structures for a two-level page table.
+//
+//	The virtual page number is split in two.  The high bits index a
+//	directory of pointers, and the low bits index a chunk of
+//	PageTableChunkSize translation entries.  A chunk is only
+//	allocated once some page in it is mapped, so a sparse address
+//	space (code at the bottom, stack near UserStackTop) only pays
+//	for the chunks it touches, and mapping more pages never copies
+//	the entries that are already there.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGETABLE_H
+#define PAGETABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "translate.h"
+
+#define PageTableChunkSize	64	// translation entries per chunk
+
+class TwoLevelPageTable {
+  public:
+    TwoLevelPageTable(unsigned maxPages);	// Empty table for virtual
+						// pages 0 .. maxPages-1
+    ~TwoLevelPageTable();
+
+    TranslationEntry *Lookup(unsigned vpn);	// NULL if vpn is not mapped
+    TranslationEntry *Map(unsigned vpn);	// The entry for vpn, allocating
+						// its chunk if needed.  The
+						// caller initializes the rest
+						// of a new entry
+    bool IsMapped(unsigned vpn);
+
+    unsigned GetNumChunks() { return numChunks; }
+    unsigned GetTableBytes();			// Host memory used by the table
+
+  private:
+    TranslationEntry **directory;	// One pointer per chunk, NULL if
+					// none of its pages is mapped.
+					// Unmapped entries of a chunk have
+					// virtualPage == -1
+    unsigned directorySize;		// Number of slots in the directory
+    unsigned numChunks;			// Number of chunks allocated
+};
+
+#endif // PAGETABLE_H
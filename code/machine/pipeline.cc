@@ -0,0 +1,278 @@
+// pipeline.cc
+//	Routines for the pipeline and branch predictor cycle model.
+//	See pipeline.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "machine.h"
+#include "mipssim.h"
+#include "pipeline.h"
+
+//----------------------------------------------------------------------
+// PipelineModel::PipelineModel
+// 	Initialize the cycle model.  The predictor's counters start
+//	out weakly taken.
+//
+//	"_predictor" -- STATIC_PREDICTOR, BIMODAL_PREDICTOR or
+//		GSHARE_PREDICTOR
+//	"_tableSize" -- number of 2-bit counters (a power of two)
+//	"_mispredictPenalty" -- ticks lost on a wrong prediction
+//----------------------------------------------------------------------
+
+PipelineModel::PipelineModel(int _predictor, int _tableSize,
+			     int _mispredictPenalty)
+{
+    int i;
+
+    ASSERT((_predictor >= STATIC_PREDICTOR) && (_predictor <= GSHARE_PREDICTOR));
+    ASSERT((_tableSize > 0) && ((_tableSize & (_tableSize - 1)) == 0));
+    predictor = _predictor;
+    tableSize = _tableSize;
+    mispredictPenalty = _mispredictPenalty;
+    counters = new unsigned char[tableSize];
+    for (i = 0; i < tableSize; i++)
+	counters[i] = 2;
+    history = 0;
+
+    clock = 0;
+    lastLoadReg = 0;
+    hiLoReady = 0;
+    loadUseStalls = hiLoStalls = 0;
+    branches = mispredicts = 0;
+}
+
+//----------------------------------------------------------------------
+// PipelineModel::~PipelineModel
+// 	De-allocate the predictor's counters.
+//----------------------------------------------------------------------
+
+PipelineModel::~PipelineModel()
+{
+    delete [] counters;
+}
+
+//----------------------------------------------------------------------
+// PipelineModel::Stalls
+// 	Account for one instruction that has just executed, and return
+//	the ticks it stalled the pipeline for.  Called by
+//	Machine::OneInstruction after the instruction has completed
+//	without an exception.
+//
+//	"instr" -- the decoded instruction
+//	"pc" -- its address
+//	"taken" -- for a conditional branch, was it taken?
+//----------------------------------------------------------------------
+
+int
+PipelineModel::Stalls(Instruction *instr, int pc, bool taken)
+{
+    int stalls = 0;
+
+    clock++;
+
+    // Forwarding cannot hide a load from the instruction right behind it
+    if ((lastLoadReg != 0) && Reads(instr, lastLoadReg)) {
+	stalls += LoadUseStall;
+	loadUseStalls += LoadUseStall;
+    }
+    lastLoadReg = 0;
+
+    switch (instr->opCode) {
+      case OP_LB:
+      case OP_LBU:
+      case OP_LH:
+      case OP_LHU:
+      case OP_LW:
+      case OP_LWL:
+      case OP_LWR:
+      case OP_LL:
+      case OP_MFC1:
+      case OP_CFC1:
+	lastLoadReg = instr->rt;
+	break;
+
+      case OP_MULT:
+      case OP_MULTU:
+	hiLoReady = clock + MultLatency;
+	break;
+
+      case OP_DIV:
+      case OP_DIVU:
+	hiLoReady = clock + DivLatency;
+	break;
+
+      case OP_MFHI:
+      case OP_MFLO:
+	if (hiLoReady > clock) {
+	    stalls += hiLoReady - clock;
+	    hiLoStalls += hiLoReady - clock;
+	}
+	break;
+
+      case OP_BEQ:
+      case OP_BGEZ:
+      case OP_BGEZAL:
+      case OP_BGTZ:
+      case OP_BLEZ:
+      case OP_BLTZ:
+      case OP_BLTZAL:
+      case OP_BNE:
+      case OP_BC1F:
+      case OP_BC1T:
+	branches++;
+	if (predictor == STATIC_PREDICTOR) {
+	    // the branch offset is negative for a backward branch
+	    if ((instr->extra < 0) != taken) {
+		mispredicts++;
+		stalls += mispredictPenalty;
+	    }
+	} else {
+	    if (Predict(pc) != taken) {
+		mispredicts++;
+		stalls += mispredictPenalty;
+	    }
+	    Train(pc, taken);
+	}
+	break;
+    }
+
+    clock += stalls;
+    return stalls;
+}
+
+//----------------------------------------------------------------------
+// PipelineModel::Reads
+// 	Does "instr" read general register "reg" as a source operand?
+//----------------------------------------------------------------------
+
+bool
+PipelineModel::Reads(Instruction *instr, int reg)
+{
+    if ((instr->opCode >= OP_FADD) && (instr->opCode <= OP_FCMP))
+	return FALSE;		// FP arithmetic reads FP registers only
+
+    switch (instr->opCode) {
+      case OP_J:
+      case OP_JAL:
+      case OP_LUI:
+      case OP_MFHI:
+      case OP_MFLO:
+      case OP_SYSCALL:
+      case OP_RES:
+      case OP_UNIMP:
+      case OP_MFC1:
+      case OP_CFC1:
+      case OP_BC1F:
+      case OP_BC1T:
+	return FALSE;
+
+      case OP_MTC1:
+      case OP_CTC1:
+	return (instr->rt == reg);
+
+      case OP_LWC1:
+      case OP_SWC1:
+      case OP_LDC1:
+      case OP_SDC1:
+	return (instr->rs == reg);
+
+      case OP_SLL:
+      case OP_SRA:
+      case OP_SRL:
+	return (instr->rt == reg);
+
+      case OP_ADDI:
+      case OP_ADDIU:
+      case OP_ANDI:
+      case OP_ORI:
+      case OP_SLTI:
+      case OP_SLTIU:
+      case OP_XORI:
+      case OP_BGEZ:
+      case OP_BGEZAL:
+      case OP_BGTZ:
+      case OP_BLEZ:
+      case OP_BLTZ:
+      case OP_BLTZAL:
+      case OP_JR:
+      case OP_JALR:
+      case OP_MTHI:
+      case OP_MTLO:
+      case OP_LB:
+      case OP_LBU:
+      case OP_LH:
+      case OP_LHU:
+      case OP_LW:
+      case OP_LL:
+	return (instr->rs == reg);
+
+      default:			// register-register operations, BEQ/BNE,
+				// stores, LWL/LWR, SC
+	return ((instr->rs == reg) || (instr->rt == reg));
+    }
+}
+
+//----------------------------------------------------------------------
+// PipelineModel::CounterIndex
+// 	The counter that predicts the branch at "pc".  Gshare mixes the
+//	global history into the branch address.
+//----------------------------------------------------------------------
+
+int
+PipelineModel::CounterIndex(int pc)
+{
+    unsigned index = ((unsigned) pc) >> 2;
+
+    if (predictor == GSHARE_PREDICTOR)
+	index ^= history;
+    return index & (tableSize - 1);
+}
+
+//----------------------------------------------------------------------
+// PipelineModel::Predict
+// 	TRUE if the counter for the branch at "pc" says taken.
+//----------------------------------------------------------------------
+
+bool
+PipelineModel::Predict(int pc)
+{
+    return (counters[CounterIndex(pc)] >= 2);
+}
+
+//----------------------------------------------------------------------
+// PipelineModel::Train
+// 	Move the branch's counter towards its outcome, and shift the
+//	outcome into the global history.
+//----------------------------------------------------------------------
+
+void
+PipelineModel::Train(int pc, bool taken)
+{
+    int i = CounterIndex(pc);
+
+    if (taken && (counters[i] < 3))
+	counters[i]++;
+    else if (!taken && (counters[i] > 0))
+	counters[i]--;
+    history = ((history << 1) | (taken ? 1 : 0)) & (tableSize - 1);
+}
+
+//----------------------------------------------------------------------
+// PipelineModel::Print
+// 	Print where the stall ticks came from.
+//----------------------------------------------------------------------
+
+void
+PipelineModel::Print()
+{
+    static char *names[] = { "static", "bimodal", "gshare" };
+
+    printf("Pipeline: load-use stalls %d, HI/LO stalls %d\n",
+	   loadUseStalls, hiLoStalls);
+    printf("Branches (%s predictor): %d, mispredicted %d, accuracy %.4f\n",
+	   names[predictor], branches, mispredicts,
+	   (branches > 0) ? (float)(branches - mispredicts)/branches : 0.0);
+}
@@ -0,0 +1,76 @@
+// pipeline.h
+//	Data structures for the cycle model of the simulated CPU's
+//	pipeline.
+//
+//	Without the model every user instruction takes UserTick.  With
+//	it (-pipe), Machine::OneInstruction also charges the stalls a
+//	simple five stage pipeline with forwarding would see:
+//
+//	  a load followed by an instruction that uses the loaded register,
+//	  reading HI or LO before a multiply or divide has finished,
+//	  a conditional branch the branch predictor got wrong.
+//
+//	The model only adds time.  It never changes what an instruction
+//	does, so programs compute the same results with or without it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// Branch predictors, used with the -pipe flag
+#define STATIC_PREDICTOR	0	// backward taken, forward not taken
+#define BIMODAL_PREDICTOR	1	// 2-bit counter per branch address
+#define GSHARE_PREDICTOR	2	// 2-bit counters indexed by the
+					// address xor the global history
+
+#define LoadUseStall		1	// ticks lost by a load-use hazard
+#define MultLatency		12	// ticks until HI/LO hold a product
+#define DivLatency		35	// ticks until HI/LO hold a quotient
+#define DefaultMispredictPenalty 2	// ticks lost by a wrong prediction
+#define DefaultPredictorSize	1024	// 2-bit counters in the predictor
+
+class Instruction;
+
+class PipelineModel {
+  public:
+    PipelineModel(int predictor, int tableSize, int mispredictPenalty);
+					// tableSize is a power of two
+    ~PipelineModel();
+
+    int Stalls(Instruction *instr, int pc, bool taken);
+					// Ticks "instr" at "pc" stalls,
+					// beyond its UserTick.  "taken"
+					// tells if a branch was taken
+
+    void Print();			// Print what the stalls came from
+
+  private:
+    bool Reads(Instruction *instr, int reg);	// does instr read reg?
+    bool Predict(int pc);		// TRUE if the branch at pc is
+					// predicted taken
+    void Train(int pc, bool taken);	// update with the outcome
+    int CounterIndex(int pc);
+
+    int predictor;			// one of the above
+    int tableSize;
+    int mispredictPenalty;
+    unsigned char *counters;		// 2-bit saturating counters
+    unsigned history;			// outcomes of recent branches,
+					// newest in bit 0
+
+    int clock;				// instructions and stalls so far
+    int lastLoadReg;			// register loaded by the previous
+					// instruction, or 0
+    int hiLoReady;			// clock at which HI/LO are ready
+
+    int loadUseStalls, hiLoStalls;	// ticks lost to each cause
+    int branches, mispredicts;
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,227 @@
+// replay.cc
+//	Routines to record and play back the inputs of a simulation.
+//	See replay.h.
+//
+//	When replaying, the whole log is read in at startup and sorted
+//	by kind, so the devices never wait on the file.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "replay.h"
+
+//----------------------------------------------------------------------
+// InputLog::InputLog
+// 	Create a log to record into, or read one in to replay.  Failing
+//	to open the log is fatal: the run would not be what was asked for.
+//
+//	"fileName" -- the host file
+//	"_recording" -- TRUE to record, FALSE to replay
+//----------------------------------------------------------------------
+
+InputLog::InputLog(char *fileName, bool _recording)
+{
+    unsigned magic, kind, delta, value;
+    int size[NumEventKinds], n, when, done;
+    InputEvent *grown, *event;
+
+    recording = _recording;
+    lastTick = 0;
+    for (kind = 0; kind < NumEventKinds; kind++) {
+	events[kind] = NULL;
+	numEvents[kind] = nextEvent[kind] = size[kind] = 0;
+    }
+
+    fp = fopen(fileName, recording ? "wb" : "rb");
+    if (fp == NULL) {
+	fprintf(stderr, "Unable to open input log %s\n", fileName);
+	Exit(1);
+    }
+    if (recording) {
+	WriteNumber(InputLogMagic);
+	return;
+    }
+
+    if (!ReadNumber(&magic) || (magic != InputLogMagic)) {
+	fprintf(stderr, "%s is not an input log\n", fileName);
+	Exit(1);
+    }
+    when = 0;
+    while (ReadNumber(&kind)) {
+	done = ReadNumber(&delta) && ReadNumber(&value);
+	ASSERT(done && (kind < NumEventKinds));
+	n = numEvents[kind];
+	if (n == size[kind]) {			// double the array
+	    size[kind] = (n == 0) ? 256 : 2 * n;
+	    grown = new InputEvent[size[kind]];
+	    if (n > 0)
+		bcopy(events[kind], grown, n * sizeof(InputEvent));
+	    delete [] events[kind];
+	    events[kind] = grown;
+	}
+	when += delta;
+	event = &events[kind][numEvents[kind]++];
+	event->when = when;
+	event->value = value;
+	event->data = NULL;
+	if (kind == NetworkEvent) {
+	    event->data = new char[value];
+	    done = fread(event->data, 1, value, fp);
+	    ASSERT(done == (int) value);
+	}
+    }
+    fclose(fp);
+    fp = NULL;
+}
+
+//----------------------------------------------------------------------
+// InputLog::~InputLog
+// 	Flush a recorded log to the file, or free a replayed one.
+//----------------------------------------------------------------------
+
+InputLog::~InputLog()
+{
+    int kind, i;
+
+    if (fp != NULL)
+	fclose(fp);
+    for (kind = 0; kind < NumEventKinds; kind++) {
+	for (i = 0; i < numEvents[kind]; i++)
+	    delete [] events[kind][i].data;
+	delete [] events[kind];
+    }
+}
+
+//----------------------------------------------------------------------
+// InputLog::WriteNumber, InputLog::ReadNumber
+// 	Store an unsigned number in 7-bit groups, low group first; the
+//	top bit of a byte says another group follows.  ReadNumber
+//	returns FALSE at the end of the file.
+//----------------------------------------------------------------------
+
+void
+InputLog::WriteNumber(unsigned n)
+{
+    while (n >= 0x80) {
+	putc((n & 0x7f) | 0x80, fp);
+	n >>= 7;
+    }
+    putc(n, fp);
+}
+
+bool
+InputLog::ReadNumber(unsigned *n)
+{
+    int c, shift = 0;
+
+    *n = 0;
+    do {
+	if ((c = getc(fp)) == EOF)
+	    return FALSE;
+	*n |= (unsigned)(c & 0x7f) << shift;
+	shift += 7;
+    } while (c & 0x80);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// InputLog::Record
+// 	Append one input, taken in now, to the log.
+//
+//	"kind" -- ConsoleEvent, NetworkEvent or RandomEvent
+//	"value" -- the character, packet length or random number
+//	"data" -- the packet, for NetworkEvent
+//----------------------------------------------------------------------
+
+void
+InputLog::Record(int kind, int value, char *data)
+{
+    int done;
+
+    ASSERT(recording && (stats->totalTicks >= lastTick));
+    WriteNumber(kind);
+    WriteNumber(stats->totalTicks - lastTick);
+    WriteNumber(value);
+    if (data != NULL) {
+	done = fwrite(data, 1, value, fp);
+	ASSERT(done == value);
+    }
+    lastTick = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// InputLog::NextDue
+// 	Take the next input of "kind" off the replay log, if it was
+//	taken in at or before the current tick, or at any time if
+//	"anyTime".  Returns NULL if there is none.
+//----------------------------------------------------------------------
+
+InputEvent *
+InputLog::NextDue(int kind, bool anyTime)
+{
+    InputEvent *event;
+
+    ASSERT(!recording);
+    if (nextEvent[kind] == numEvents[kind])
+	return NULL;
+    event = &events[kind][nextEvent[kind]];
+    if (!anyTime && (event->when > stats->totalTicks))
+	return NULL;
+    nextEvent[kind]++;
+    return event;
+}
+
+void
+InputLog::RecordChar(char ch)
+{
+    Record(ConsoleEvent, (unsigned char) ch, NULL);
+}
+
+bool
+InputLog::ReplayChar(char *ch)
+{
+    InputEvent *event = NextDue(ConsoleEvent, FALSE);
+
+    if (event == NULL)
+	return FALSE;
+    *ch = (char) event->value;
+    return TRUE;
+}
+
+void
+InputLog::RecordPacket(char *packet, int length)
+{
+    Record(NetworkEvent, length, packet);
+}
+
+int
+InputLog::ReplayPacket(char *packet, int maxLength)
+{
+    InputEvent *event = NextDue(NetworkEvent, FALSE);
+
+    if (event == NULL)
+	return 0;
+    ASSERT(event->value <= maxLength);
+    bcopy(event->data, packet, event->value);
+    return event->value;
+}
+
+void
+InputLog::RecordRandom(int value)
+{
+    Record(RandomEvent, value, NULL);
+}
+
+bool
+InputLog::ReplayRandom(int *value)
+{
+    InputEvent *event = NextDue(RandomEvent, TRUE);
+
+    if (event == NULL)
+	return FALSE;
+    *value = event->value;
+    return TRUE;
+}
@@ -0,0 +1,93 @@
+// replay.h
+//	Data structures to record the inputs that make a simulation
+//	non-deterministic, and to play them back later.
+//
+//	  nachos -record <log> ...	log every input as it happens
+//	  nachos -replay <log> ...	take the inputs from the log
+//
+//	The inputs are the characters typed at the console, the packets
+//	that arrive from the network, and the values drawn from the
+//	random number generator (random timer yields with -rs, lost
+//	packets, random page replacement).  Each is logged with the tick
+//	at which the simulation took it in.
+//
+//	A replay reads no keyboard and opens no sockets.  A character
+//	or packet is delivered at the first poll at or after its logged
+//	tick, and random numbers are handed out in logged order.  Run
+//	with the same kernel and flags, a replay is identical to the
+//	recorded run, tick for tick.  With a changed kernel, it still
+//	sees the same inputs at (nearly) the same times, so the two
+//	kernels can be compared on the same workload.
+//
+//	The log is a header followed by one record per input: a kind
+//	byte, the ticks since the previous record, and the input itself;
+//	numbers are stored in 7-bit groups, so most take one or two bytes.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// Kinds of inputs
+#define ConsoleEvent	0
+#define NetworkEvent	1
+#define RandomEvent	2
+#define NumEventKinds	3
+
+#define InputLogMagic	0x4e52504c	// first word of a log file
+
+// One logged input
+
+class InputEvent {
+  public:
+    int when;				// tick it was taken in
+    int value;				// the character, the random number,
+					// or the packet length
+    char *data;				// the packet, NULL otherwise
+};
+
+// The log of one simulation, being written or played back
+
+class InputLog {
+  public:
+    InputLog(char *fileName, bool recording);	// Create, or load, a log
+    ~InputLog();			// Finish writing the log
+
+    bool IsRecording() { return recording; }
+    bool IsReplaying() { return !recording; }
+
+    void RecordChar(char ch);		// A character was typed
+    bool ReplayChar(char *ch);		// Is one due by now?  If so,
+					// return it in ch
+
+    void RecordPacket(char *packet, int length);
+    int ReplayPacket(char *packet, int maxLength);
+					// Length of the packet due by now,
+					// copied into packet, or 0 if none
+
+    void RecordRandom(int value);
+    bool ReplayRandom(int *value);	// FALSE once the log runs out
+
+  private:
+    void Record(int kind, int value, char *data);
+    InputEvent *NextDue(int kind, bool anyTime);
+					// next unused input of this kind,
+					// if it is due (or anyTime)
+    void WriteNumber(unsigned n);
+    bool ReadNumber(unsigned *n);
+
+    bool recording;
+    FILE *fp;				// the log file, when recording
+    int lastTick;			// tick of the last record
+
+    InputEvent *events[NumEventKinds];	// when replaying, the inputs of
+    int numEvents[NumEventKinds];	// each kind in order, and the
+    int nextEvent[NumEventKinds];	// next one to hand out
+};
+
+#endif // REPLAY_H
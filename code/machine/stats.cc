@@ -22,6 +22,14 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numSyscalls = 0;
+    for (int i = 0; i < MaxSyscalls; i++)
+        syscallCalls[i] = syscallTicks[i] = syscallMaxTicks[i] = 0;
+    priorityInversions = inversionTicks = 0;
+    maxPageTableBytes = 0;
+    pageSize = numLargePages = 0;
+    numTLBHits = numTLBMisses = 0;
+    cacheStallTicks = pipelineStallTicks = 0;
     
     total_wait_time = 0;
     cpu_time = 0;
@@ -50,7 +58,34 @@ Statistics::Print()
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
+    printf("System calls: %d\n", numSyscalls);
+#ifdef USER_PROGRAM
+    for (int i = 0; i < MaxSyscalls; i++) {
+        if (syscallCalls[i] > 0)
+            printf("  %-14s calls %d, ticks total %d, max %d, mean %.2f\n",
+                   SyscallName(i), syscallCalls[i], syscallTicks[i],
+                   syscallMaxTicks[i], (float)syscallTicks[i]/syscallCalls[i]);
+    }
+#endif
+    if (priorityInversions > 0)
+	printf("Priority inversions: %d, %d ticks\n", priorityInversions,
+	       inversionTicks);
     printf("Paging: faults %d\n", numPageFaults);
+    printf("Page tables: largest %d bytes\n", maxPageTableBytes);
+    if (pageSize > 0) {
+        printf("Page size: %d bytes, large pages mapped: %d, faults per 1000 user ticks: %.2f\n",
+               pageSize, numLargePages, (userTicks > 0) ? (1000.0*numPageFaults)/userTicks : 0.0);
+    }
+    if (numTLBHits + numTLBMisses > 0) {
+        printf("TLB: hits %d, misses %d, hit ratio %.4f\n", numTLBHits, numTLBMisses,
+               (float)numTLBHits/(numTLBHits + numTLBMisses));
+    }
+    if (cacheStallTicks > 0) {
+        printf("Cache: ticks stalled on misses %d\n", cacheStallTicks);
+    }
+    if (pipelineStallTicks > 0) {
+        printf("Pipeline: ticks stalled %d\n", pipelineStallTicks);
+    }
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
 
@@ -13,6 +13,8 @@
 
 #include "copyright.h"
 
+#define MaxSyscalls	64	// system call codes are below this
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -48,6 +50,23 @@ class Statistics {
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
+    int numSyscalls;		// number of system calls made
+    int syscallCalls[MaxSyscalls];	// calls made of each system call,
+    int syscallTicks[MaxSyscalls];	// the ticks from trap to return
+    int syscallMaxTicks[MaxSyscalls];	// (blocking included), and the
+					// most that one call took
+    int priorityInversions;	// waits on a Lock or mutex Semaphore
+				// held by a lower priority thread
+    int inversionTicks;		// ticks spent in those waits
+    int maxPageTableBytes;	// host memory taken by the largest page
+				// table of any process
+    int pageSize;		// bytes per page (0 without user programs)
+    int numLargePages;		// large pages mapped
+    int numTLBHits;		// translations found in the TLB
+    int numTLBMisses;		// translations that trapped to the kernel
+    int cacheStallTicks;	// time spent waiting for cache misses
+    int pipelineStallTicks;	// time lost to pipeline hazards and
+				// mispredicted branches
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
 
@@ -56,6 +75,10 @@ class Statistics {
     void Print();		// print collected statistics
 };
 
+#ifdef USER_PROGRAM
+extern const char *SyscallName(int type);	// in userprog/exception.cc
+#endif
+
 // Constants used to reflect the relative time an operation would
 // take in a real system.  A "tick" is a just a unit of time -- if you 
 // like, a microsecond.
@@ -432,14 +432,17 @@ Exit(int exitCode)
 
 //----------------------------------------------------------------------
 // RandomInit
-// 	Initialize the pseudo-random number generator.  We use the
-//	now obsolete "srand" and "rand" because they are more portable!
+// 	Initialize the pseudo-random number generator.  Each simulation
+//	has its own generator state, so simulations running side by side
+//	(see sweep.cc) draw independent, repeatable streams.
 //----------------------------------------------------------------------
 
+static SimulationLocal unsigned randomState = 1;
+
 void
 RandomInit(unsigned seed)
 {
-    srand(seed);
+    randomState = seed;
 }
 
 //----------------------------------------------------------------------
@@ -450,7 +453,27 @@ RandomInit(unsigned seed)
 int
 Random()
 {
-    return rand();
+    int value;
+
+    if ((inputLog != NULL) && inputLog->IsReplaying() &&
+					inputLog->ReplayRandom(&value))
+	return value;
+    value = rand_r(&randomState);
+    if ((inputLog != NULL) && inputLog->IsRecording())
+	inputLog->RecordRandom(value);
+    return value;
+}
+
+//----------------------------------------------------------------------
+// RandomState
+// 	Return the generator state, so that a checkpoint can carry on
+//	the same pseudo-random sequence after it is restored.
+//----------------------------------------------------------------------
+
+unsigned
+RandomState()
+{
+    return randomState;
 }
 
 //----------------------------------------------------------------------
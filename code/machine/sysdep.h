@@ -49,6 +49,8 @@ extern void CallOnUserAbort(VoidNoArgFunctionPtr cleanUp);
 // Initialize the pseudo random number generator
 extern void RandomInit(unsigned seed);
 extern int Random();
+extern unsigned RandomState();	// RandomInit(RandomState()) resumes
+				// the current stream
 
 // Allocate, de-allocate an array, such that de-referencing
 // just beyond either end of the array will cause an error
@@ -98,6 +98,7 @@ Machine::ReadMem(int addr, int size, int *value)
 	machine->RaiseException(exception, addr);
 	return FALSE;
     }
+    CacheReference(DCACHE, physicalAddress);
     switch (size) {
       case 1:
 	data = machine->mainMemory[physicalAddress];
@@ -147,6 +148,10 @@ Machine::WriteMem(int addr, int size, int value)
 	machine->RaiseException(exception, addr);
 	return FALSE;
     }
+    if ((linkAddress != -1) && ((physicalAddress / LinkLineSize) ==
+					(linkAddress / LinkLineSize)))
+	linkAddress = -1;		// someone stored to the linked line
+    CacheReference(DCACHE, physicalAddress);
     switch (size) {
       case 1:
 	machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
@@ -168,6 +173,133 @@ Machine::WriteMem(int addr, int size, int value)
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Machine::LoadLinked
+//      Read the word at virtual address "addr" into "value", like
+//	ReadMem, and link the CPU to its physical address.
+//
+//   	Returns FALSE if the translation step from virtual to physical memory
+//   	failed.
+//----------------------------------------------------------------------
+
+bool
+Machine::LoadLinked(int addr, int *value)
+{
+    ExceptionType exception;
+    int physicalAddress;
+
+    exception = Translate(addr, &physicalAddress, 4, FALSE);
+    if (exception != NoException) {
+	machine->RaiseException(exception, addr);
+	return FALSE;
+    }
+    CacheReference(DCACHE, physicalAddress);
+    *value = WordToHost(*(unsigned int *) &machine->mainMemory[physicalAddress]);
+    linkAddress = physicalAddress;
+    DEBUG('a', "Load linked VA 0x%x, PA 0x%x, value %8.8x\n", addr,
+	  physicalAddress, *value);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::StoreConditional
+//      Write "value" to the word at virtual address "addr", like
+//	WriteMem, but only if the link made by LoadLinked to that word
+//	is still there.  Either way, the link is gone afterwards.
+//
+//   	Returns FALSE if the translation step from virtual to physical memory
+//   	failed.  Otherwise "stored" tells if the word was written.
+//----------------------------------------------------------------------
+
+bool
+Machine::StoreConditional(int addr, int value, bool *stored)
+{
+    ExceptionType exception;
+    int physicalAddress;
+
+    exception = Translate(addr, &physicalAddress, 4, TRUE);
+    if (exception != NoException) {
+	machine->RaiseException(exception, addr);
+	return FALSE;
+    }
+    *stored = (linkAddress == physicalAddress);
+    linkAddress = -1;
+    if (*stored) {
+	CacheReference(DCACHE, physicalAddress);
+	*(unsigned int *) &machine->mainMemory[physicalAddress]
+		= WordToMachine((unsigned int) value);
+    }
+    DEBUG('a', "Store conditional VA 0x%x, %s\n", addr,
+	  *stored ? "stored" : "failed");
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::BreakLinkToFrame
+//      The kernel has given physical page "frame" to another page, so
+//	a link into it no longer means anything.
+//----------------------------------------------------------------------
+
+void
+Machine::BreakLinkToFrame(int frame)
+{
+    if ((linkAddress != -1) && ((linkAddress / PageSize) == frame))
+	linkAddress = -1;
+}
+
+//----------------------------------------------------------------------
+// Machine::FetchInstruction
+//      Read the instruction word at virtual address "addr" into
+//	"value", like ReadMem but through the instruction cache.
+//
+//   	Returns FALSE if the translation step from virtual to physical memory
+//   	failed.
+//----------------------------------------------------------------------
+
+bool
+Machine::FetchInstruction(int addr, int *value)
+{
+    ExceptionType exception;
+    int physicalAddress;
+
+    exception = Translate(addr, &physicalAddress, 4, FALSE);
+    if (exception != NoException) {
+	machine->RaiseException(exception, addr);
+	return FALSE;
+    }
+    CacheReference(ICACHE, physicalAddress);
+    *value = WordToHost(*(unsigned int *) &machine->mainMemory[physicalAddress]);
+
+    DEBUG('a', "\tinstruction fetched from 0x%x = %8.8x\n", addr, *value);
+    return (TRUE);
+}
+
+//----------------------------------------------------------------------
+// Machine::CacheReference
+//      Look "physAddr" up in the instruction or data cache, if that
+//	cache is modelled.  A miss stalls the machine for the cache's
+//	miss penalty.  The outcome is counted for the current thread.
+//
+//	"which" -- ICACHE or DCACHE
+//----------------------------------------------------------------------
+
+void
+Machine::CacheReference(int which, int physAddr)
+{
+    Cache *cache = (which == ICACHE) ? icache : dcache;
+
+    if (cache == NULL)
+	return;
+    if (cache->Access(physAddr)) {
+	currentThread->IncCacheHitCount(which);
+    } else {
+	currentThread->IncCacheMissCount(which);
+	if (scheduler->MovesClock())	// with -cpus, only one CPU
+	    stats->totalTicks += cache->GetMissPenalty();	// moves the clock
+	stats->cacheStallTicks += cache->GetMissPenalty();
+    }
+}
+
 //----------------------------------------------------------------------
 // Machine::Translate
 // 	Translate a virtual address into a physical address, using
@@ -199,9 +331,10 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	return AddressErrorException;
     }
 
-    // we must have either a TLB or a page table, but not both!
-    ASSERT(tlb == NULL || NachOSpageTable == NULL);
-    ASSERT(tlb != NULL || NachOSpageTable != NULL);
+    // we must have either a TLB or a page table.  With a TLB the
+    // kernel keeps the page table installed too, for its miss handler,
+    // but the hardware only looks at the TLB.
+    ASSERT(tlb != NULL || NachOSpageTable != NULL || pageDirectory != NULL);
 
 // calculate the virtual page number, and offset within the page,
 // from the virtual address
@@ -209,28 +342,32 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     offset = (unsigned) virtAddr % PageSize;
 
     if (tlb == NULL) {		// => page table => vpn is index into table
-	if (vpn >= NachOSpageTableSize) {
+	if (vpn >= NachOSpageTableSize && vpn >= stackPageTableTop) {
 	    DEBUG('a', "virtual page # %d too large for page table size %d!\n",
 			virtAddr, NachOSpageTableSize);
 	    return AddressErrorException;
-	} else if (!NachOSpageTable[vpn].valid) {
-	    DEBUG('a', "virtual page # %d too large for page table size %d!\n",
-			virtAddr, NachOSpageTableSize);
-            return PageFaultException;
 	}
-	entry = &NachOSpageTable[vpn];
-    } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-    	    if (tlb[i].valid && (tlb[i].virtualPage == vpn)) {
-		entry = &tlb[i];			// FOUND!
-		break;
+	entry = PageTableLookup(vpn);
+	if (entry == NULL || !entry->valid) {
+	    // Maybe vpn is covered by the entry of a large page
+	    entry = PageTableLookup(vpn - vpn % LargePageFactor);
+	    if (entry == NULL || !entry->valid || !entry->largePage) {
+		DEBUG('a', "virtual page # %d not in memory!\n", vpn);
+		return PageFaultException;
 	    }
-	if (entry == NULL) {				// not found
+	}
+    } else {
+	i = TLBLookup(vpn);
+	if (i == -1) {					// not found
     	    DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
+	    stats->numTLBMisses++;
     	    return PageFaultException;		// really, this is a TLB fault,
 						// the page may be in memory,
 						// but not in the TLB
 	}
+	entry = &tlb[i];				// FOUND!
+	tlbLastUsed[i] = stats->totalTicks;
+	stats->numTLBHits++;
     }
 
     if (entry->readOnly && writing) {	// trying to write to a read-only page
@@ -238,10 +375,12 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	return ReadOnlyException;
     }
     pageFrame = entry->physicalPage;
+    if (entry->largePage)
+	pageFrame += vpn % LargePageFactor;
 
     // if the pageFrame is too big, there is something really wrong!
     // An invalid translation was loaded into the page table or TLB.
-    if (pageFrame >= NumPhysPages) {
+    if (pageFrame >= (unsigned) NumPhysPages) {
 	DEBUG('a', "*** frame %d > %d!\n", pageFrame, NumPhysPages);
 	return BusErrorException;
     }
@@ -274,11 +413,77 @@ Machine::GetPA (unsigned vaddr)
    TranslationEntry *entry;
    unsigned int pageFrame;
 
-   if ((vpn < NachOSpageTableSize) && NachOSpageTable[vpn].valid) {
-      entry = &NachOSpageTable[vpn];
+   entry = PageTableLookup(vpn);
+   if ((entry == NULL) || !entry->valid) {
+      entry = PageTableLookup(vpn - vpn % LargePageFactor);
+      if ((entry != NULL) && !entry->largePage) entry = NULL;
+   }
+   if ((entry != NULL) && entry->valid) {
       pageFrame = entry->physicalPage;
-      if (pageFrame >= NumPhysPages) return -1;
+      if (entry->largePage) pageFrame += vpn % LargePageFactor;
+      if (pageFrame >= (unsigned) NumPhysPages) return -1;
       return pageFrame * PageSize + offset;
    }
    else return -1;
 }
+
+//----------------------------------------------------------------------
+// Machine::PageTableLookup
+//      Returns the entry for virtual page "vpn" in the two-level page
+//      table, or else in the low page table or the stack page table.
+//      Returns NULL if vpn is not mapped.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+Machine::PageTableLookup (unsigned vpn)
+{
+   if (pageDirectory != NULL)
+      return pageDirectory->Lookup(vpn);
+   if ((NachOSpageTable != NULL) && (vpn < NachOSpageTableSize))
+      return &NachOSpageTable[vpn];
+   if ((stackPageTable != NULL) && (vpn < stackPageTableTop)
+       && (stackPageTableTop - 1 - vpn < stackPageTableSize))
+      return &stackPageTable[stackPageTableTop - 1 - vpn];
+   return NULL;
+}
+
+//----------------------------------------------------------------------
+// Machine::TLBSetOf
+//      Returns the index of the first TLB entry of the set that
+//      virtual page "vpn" maps to.
+//----------------------------------------------------------------------
+
+int
+Machine::TLBSetOf (unsigned vpn)
+{
+   return (vpn % (tlbSize / tlbWays)) * tlbWays;
+}
+
+//----------------------------------------------------------------------
+// Machine::TLBLookup
+//      Associative lookup of "vpn" in its TLB set, for the current
+//      address space.  A large page is entered in the set of its first
+//      page, so that set is searched too.  Returns the index of the
+//      matching entry, or -1 on a miss.
+//----------------------------------------------------------------------
+
+int
+Machine::TLBLookup (unsigned vpn)
+{
+   unsigned first = vpn - vpn % LargePageFactor;
+   int i, set;
+
+   set = TLBSetOf(vpn);
+   for (i = set; i < set + tlbWays; i++) {
+      if (tlb[i].valid && (tlb[i].asid == currentASID) &&
+          (tlb[i].virtualPage == (int) vpn))
+         return i;
+   }
+   set = TLBSetOf(first);
+   for (i = set; i < set + tlbWays; i++) {
+      if (tlb[i].valid && (tlb[i].asid == currentASID) && tlb[i].largePage &&
+          (tlb[i].virtualPage == (int) first))
+         return i;
+   }
+   return -1;
+}
@@ -43,6 +43,14 @@ class TranslationEntry {
     bool shared;        // This bit is set if the page is shared
 
     bool ifUsed;     // If it has been loaded before
+
+    int advice;      // MADV_NORMAL, MADV_SEQUENTIAL or MADV_RANDOM
+                     // (see syscall.h)
+    bool locked;     // Pinned in memory by MADV_LOCK
+    bool largePage;  // This entry maps LargePageFactor pages, starting
+                     // at virtualPage and physicalPage (see machine.h)
+
+    int asid;        // In the TLB: address space that loaded the entry
 };
 
 #endif
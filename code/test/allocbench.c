@@ -0,0 +1,92 @@
+/* allocbench.c
+ *	Allocation-heavy workload for the heap and the VM.
+ *
+ *	Runs the same pseudo-random sequence of allocations and frees
+ *	twice: once through the size-class malloc/free library, and once
+ *	through a bump allocator on top of system_call_Sbrk that never
+ *	reuses memory.  Prints the ticks, instructions and page faults
+ *	each run took.
+ */
+
+#include "syscall.h"
+#include "malloc.h"
+
+#define NUM_LIVE	64	/* blocks held at any time */
+#define NUM_OPS		300	/* allocate/free pairs per run */
+#define MAX_REQUEST	512	/* largest request, in bytes */
+
+static int *live[NUM_LIVE];
+static unsigned int seed;
+
+static unsigned int
+NextRandom(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+static void *
+BumpAlloc(unsigned int size)
+{
+    int p = system_call_Sbrk((size + 7) & ~7);
+    return (p == -1) ? 0 : (void *)p;
+}
+
+static void
+BumpFree(void *ptr)
+{
+}
+
+static void
+Report(char *name, int ticks, int instrs, int faults)
+{
+    system_call_PrintString(name);
+    system_call_PrintString(": ticks ");
+    system_call_PrintInt(ticks);
+    system_call_PrintString(", instructions ");
+    system_call_PrintInt(instrs);
+    system_call_PrintString(", page faults ");
+    system_call_PrintInt(faults);
+    system_call_PrintChar('\n');
+}
+
+static void
+Run(char *name, void *(*alloc)(unsigned int), void (*release)(void *))
+{
+    int i, slot, size, startTicks, startInstrs, startFaults;
+
+    seed = 1;
+    for (i = 0; i < NUM_LIVE; i++) live[i] = 0;
+
+    startTicks = system_call_GetTime();
+    startInstrs = system_call_GetNumInstr();
+    startFaults = system_call_GetNumPageFaults();
+
+    for (i = 0; i < NUM_OPS; i++) {
+	slot = NextRandom() % NUM_LIVE;
+	size = 4 + NextRandom() % MAX_REQUEST;
+	if (live[slot] != 0) (*release)(live[slot]);
+	live[slot] = (int *)(*alloc)(size);
+	if (live[slot] == 0) {
+	    system_call_PrintString(name);
+	    system_call_PrintString(": out of memory\n");
+	    break;
+	}
+	live[slot][0] = i;		/* touch the block */
+    }
+    for (i = 0; i < NUM_LIVE; i++) {
+	if (live[i] != 0) (*release)(live[i]);
+    }
+
+    Report(name, system_call_GetTime() - startTicks,
+	   system_call_GetNumInstr() - startInstrs,
+	   system_call_GetNumPageFaults() - startFaults);
+}
+
+int
+main()
+{
+    Run("malloc/free", malloc, free);
+    Run("sbrk bump", BumpAlloc, BumpFree);
+    return 0;
+}
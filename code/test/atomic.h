@@ -0,0 +1,27 @@
+/* atomic.h
+ *	Atomic operations and spin locks for user programs, built on the
+ *	LL and SC instructions.
+ *
+ *	Link atomic.o after start.o.  The operations work on words that
+ *	more than one process can see, e.g. from system_call_ShmAllocate.
+ *	A process that finds a spin lock held gives up the CPU with
+ *	system_call_Yield before trying again.
+ */
+
+#ifndef ATOMIC_H
+#define ATOMIC_H
+
+/* Add "delta" to *p, and return the new value. */
+int AtomicAdd(int *p, int delta);
+
+/* Set *p to "new", and return the old value. */
+int AtomicSwap(int *p, int new);
+
+/* If *p is "old", set it to "new" and return 1; otherwise return 0. */
+int CompareAndSwap(int *p, int old, int new);
+
+/* Take, and give back, the spin lock *lock, which starts out 0. */
+void SpinLock(int *lock);
+void SpinUnlock(int *lock);
+
+#endif /* ATOMIC_H */
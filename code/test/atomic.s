@@ -0,0 +1,80 @@
+/* atomic.s
+ *	Atomic operations for user programs.  See atomic.h.
+ *
+ *	Each one loads the word with LL, and stores it back with SC,
+ *	which fails if anything else got at the word in between; then
+ *	it starts over.  The arguments are in r4..r6, the result in r2.
+ *
+ *	The simulator gives LL the delay slot of an ordinary load, so
+ *	the instruction after it still sees the old register: each LL
+ *	is followed by a nop.
+ */
+
+#define IN_ASM
+#include "syscall.h"
+
+        .text   
+        .align  2
+	.set	mips2		/* for LL and SC */
+
+	.globl AtomicAdd
+	.ent	AtomicAdd
+AtomicAdd:
+	ll	$8,0($4)
+	nop
+	addu	$8,$8,$5
+	move	$2,$8
+	sc	$8,0($4)
+	beq	$8,$0,AtomicAdd
+	j	$31
+	.end AtomicAdd
+
+	.globl AtomicSwap
+	.ent	AtomicSwap
+AtomicSwap:
+	ll	$2,0($4)
+	nop
+	move	$8,$5
+	sc	$8,0($4)
+	beq	$8,$0,AtomicSwap
+	j	$31
+	.end AtomicSwap
+
+	.globl CompareAndSwap
+	.ent	CompareAndSwap
+CompareAndSwap:
+	ll	$8,0($4)
+	nop
+	bne	$8,$5,casFailed
+	move	$8,$6
+	sc	$8,0($4)
+	beq	$8,$0,CompareAndSwap
+	addiu	$2,$0,1
+	j	$31
+casFailed:
+	move	$2,$0
+	j	$31
+	.end CompareAndSwap
+
+	.globl SpinLock
+	.ent	SpinLock
+SpinLock:
+	ll	$8,0($4)
+	nop
+	bne	$8,$0,spinYield
+	addiu	$8,$0,1
+	sc	$8,0($4)
+	beq	$8,$0,SpinLock
+	j	$31
+spinYield:
+	addiu	$2,$0,SYScall_Yield	/* let the holder run */
+	syscall
+	j	SpinLock
+	.end SpinLock
+
+	.globl SpinUnlock
+	.ent	SpinUnlock
+SpinUnlock:
+	sw	$0,0($4)
+	j	$31
+	.end SpinUnlock
@@ -0,0 +1,44 @@
+#include "syscall.h"
+#include "atomic.h"
+
+#define NUM_ITER 200
+
+int
+main()
+{
+    int *array = (int*)system_call_ShmAllocate(4*sizeof(int)); // atomic count, locked count, lock, CAS count
+    int x, i, old;
+
+    for (i=0; i<4; i++) array[i] = 0;
+
+    x = system_call_Fork();
+    for (i=0; i<NUM_ITER; i++) {
+       AtomicAdd(&array[0], 1);
+       SpinLock(&array[2]);
+       array[1]++;
+       SpinUnlock(&array[2]);
+       do {
+          old = array[3];
+       } while (!CompareAndSwap(&array[3], old, old+1));
+    }
+    if (x != 0) {
+       x=system_call_Join(x);
+       system_call_PrintString("Atomic count=");
+       system_call_PrintInt(array[0]);
+       system_call_PrintChar('\n');
+       system_call_PrintString("Locked count=");
+       system_call_PrintInt(array[1]);
+       system_call_PrintChar('\n');
+       system_call_PrintString("CAS count=");
+       system_call_PrintInt(array[3]);
+       system_call_PrintChar('\n');
+       if ((array[0] == 2*NUM_ITER) && (array[1] == 2*NUM_ITER) &&
+           (array[3] == 2*NUM_ITER) && (AtomicSwap(&array[0], 0) == 2*NUM_ITER) &&
+           (array[0] == 0)) {
+          system_call_PrintString("Atomic operations OK\n");
+       } else {
+          system_call_PrintString("Atomic operations FAILED\n");
+       }
+    }
+    return 0;
+}
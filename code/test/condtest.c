@@ -0,0 +1,46 @@
+#include "syscall.h"
+#include "synchop.h"
+
+#define NUM_ITER 50
+
+int
+main()
+{
+    int *array = (int*)system_call_ShmAllocate(3*sizeof(int)); // full, item, sum
+    int mutex, cond, x, i, one = 1;
+
+    for (i=0; i<3; i++) array[i] = 0;
+
+    mutex = system_call_SemGet(1);
+    system_call_SemCtl(mutex, SYNCH_SET, &one);
+    cond = system_call_CondGet(1);
+
+    x = system_call_Fork();
+    if (x == 0) {				/* consumer */
+       for (i=0; i<NUM_ITER; i++) {
+          system_call_SemOp(mutex, -1);
+          while (!array[0]) system_call_CondOp(cond, COND_OP_WAIT, mutex);
+          array[2] += array[1];
+          array[0] = 0;
+          system_call_CondOp(cond, COND_OP_SIGNAL, mutex);
+          system_call_SemOp(mutex, 1);
+       }
+    }
+    else {					/* producer */
+       for (i=1; i<=NUM_ITER; i++) {
+          system_call_SemOp(mutex, -1);
+          while (array[0]) system_call_CondOp(cond, COND_OP_WAIT, mutex);
+          array[1] = i;
+          array[0] = 1;
+          system_call_CondOp(cond, COND_OP_SIGNAL, mutex);
+          system_call_SemOp(mutex, 1);
+       }
+       x=system_call_Join(x);
+       system_call_PrintString("Sum=");
+       system_call_PrintInt(array[2]);
+       system_call_PrintChar('\n');
+       system_call_CondRemove(cond);
+       system_call_SemCtl(mutex, SYNCH_REMOVE, 0);
+    }
+    return 0;
+}
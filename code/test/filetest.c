@@ -0,0 +1,59 @@
+#include "syscall.h"
+
+#define NUM_RECORDS 64
+#define RECORD_SIZE 64
+
+/* Parent and child write records into one file through the descriptor
+ * the child inherits, so they share the position: no record is
+ * overwritten.  The file is then read back in large blocks.
+ */
+
+char record[RECORD_SIZE];
+char block[NUM_RECORDS*RECORD_SIZE];
+
+void MakeRecord (char c)
+{
+   int i;
+
+   for (i=0; i<RECORD_SIZE-1; i++) record[i] = c;
+   record[RECORD_SIZE-1] = '\n';
+}
+
+int
+main()
+{
+    int fd, x, i, n, count[2];
+
+    system_call_Create("filetest.out");
+    fd = system_call_Open("filetest.out");
+    if (fd < 0) {
+       system_call_PrintString("Cannot open filetest.out\n");
+       return 1;
+    }
+
+    x = system_call_Fork();
+    MakeRecord((x == 0) ? 'c' : 'p');
+    for (i=0; i<NUM_RECORDS/2; i++) {
+       system_call_Write(record, RECORD_SIZE, fd);
+       system_call_Yield();
+    }
+    if (x == 0) return 0;
+
+    system_call_Join(x);
+    system_call_Close(fd);
+
+    fd = system_call_Open("filetest.out");
+    n = system_call_Read(block, sizeof(block), fd);
+    count[0] = count[1] = 0;
+    for (i=0; i<n; i+=RECORD_SIZE) count[block[i] == 'c']++;
+    system_call_Close(fd);
+
+    system_call_Write("Bytes read=", 11, ConsoleOutput);
+    system_call_PrintInt(n);
+    system_call_PrintString(", parent records=");
+    system_call_PrintInt(count[0]);
+    system_call_PrintString(", child records=");
+    system_call_PrintInt(count[1]);
+    system_call_PrintChar('\n');
+    return 0;
+}
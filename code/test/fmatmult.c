@@ -0,0 +1,48 @@
+/* fmatmult.c 
+ *    Test program to do floating point matrix multiplication, and
+ *    a double precision dot product, on the FP coprocessor.
+ *
+ *    C[i][j] comes to 2.5*i*j, and the dot product to 4940, so the
+ *    program exits with 902 (C[Dim-1][Dim-1], truncated).
+ */
+
+#include "syscall.h"
+
+#define Dim 	20
+
+float A[Dim][Dim];
+float B[Dim][Dim];
+float C[Dim][Dim];
+double x[Dim], y[Dim];
+
+int
+main()
+{
+    int i, j, k;
+    double dot;
+
+    for (i = 0; i < Dim; i++)		/* first initialize the matrices */
+	for (j = 0; j < Dim; j++) {
+	     A[i][j] = i * 0.5;
+	     B[i][j] = j * 0.25;
+	     C[i][j] = 0;
+	}
+
+    for (i = 0; i < Dim; i++)		/* then multiply them together */
+	for (j = 0; j < Dim; j++)
+            for (k = 0; k < Dim; k++)
+		 C[i][j] += A[i][k] * B[k][j];
+
+    for (i = 0; i < Dim; i++) {		/* and take a dot product */
+	x[i] = i;
+	y[i] = i / 0.5;
+    }
+    dot = 0;
+    for (i = 0; i < Dim; i++)
+	dot += x[i] * y[i];
+
+    system_call_PrintString("Dot product=");
+    system_call_PrintInt((int) dot);
+    system_call_PrintChar('\n');
+    system_call_Exit((int) C[Dim-1][Dim-1]);	/* and then we're done */
+}
@@ -0,0 +1,54 @@
+#include "syscall.h"
+#include "atomic.h"
+
+#define NUM_ITER 200
+
+/* A mutex word is 0 when free, 1 when held, and 2 when held with
+ * (perhaps) someone asleep on it.  Only the last case traps.
+ */
+
+void MutexLock (int *m)
+{
+   int c;
+
+   if (CompareAndSwap(m, 0, 1)) return;		/* free: no system call */
+   c = AtomicSwap(m, 2);
+   while (c != 0) {
+      system_call_FutexWait(m, 2);
+      c = AtomicSwap(m, 2);
+   }
+}
+
+void MutexUnlock (int *m)
+{
+   if (AtomicAdd(m, -1) != 0) {		/* was 2: wake a sleeper */
+      *m = 0;
+      system_call_FutexWake(m, 1);
+   }
+}
+
+int
+main()
+{
+    int *array = (int*)system_call_ShmAllocate(2*sizeof(int)); // count, mutex
+    int x, i, j;
+
+    array[0] = 0;
+    array[1] = 0;
+
+    x = system_call_Fork();
+    for (i=0; i<NUM_ITER; i++) {
+       MutexLock(&array[1]);
+       j = array[0];
+       system_call_Yield();		/* let the other process contend */
+       array[0] = j + 1;
+       MutexUnlock(&array[1]);
+    }
+    if (x != 0) {
+       x=system_call_Join(x);
+       system_call_PrintString("Count=");
+       system_call_PrintInt(array[0]);
+       system_call_PrintChar('\n');
+    }
+    return 0;
+}
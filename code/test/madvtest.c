@@ -0,0 +1,78 @@
+/* madvtest.c
+ *	Exercises the system_call_Madvise hints.
+ *
+ *	Pins a small hot table with MADV_LOCK, then scans a big array
+ *	twice, once with no hint and once with MADV_SEQUENTIAL, touching
+ *	the hot table between pages.  Prints the page faults and ticks
+ *	each scan took.  Run with a replacement algorithm (-R) and a
+ *	small memory to see the read ahead and the pinned pages at work.
+ *	Finally drops the array with MADV_DONTNEED and checks that it
+ *	reads back as zero.
+ */
+
+#include "syscall.h"
+
+#define HOT_SIZE	64	/* ints in the pinned table */
+#define SCAN_SIZE	(16 * 1024)	/* ints in the scanned array */
+#define STRIDE		32	/* ints per page */
+
+int hot[HOT_SIZE];
+int scan[SCAN_SIZE];
+
+int
+Scan(void)
+{
+    int i, sum = 0;
+
+    for (i = 0; i < SCAN_SIZE; i++) {
+        scan[i] = i;
+        sum += scan[i];
+        if ((i % STRIDE) == 0) sum += hot[i % HOT_SIZE]++;
+    }
+    return sum;
+}
+
+void
+Report(char *label, int faults, int ticks)
+{
+    system_call_PrintString(label);
+    system_call_PrintString(": page faults ");
+    system_call_PrintInt(faults);
+    system_call_PrintString(", ticks ");
+    system_call_PrintInt(ticks);
+    system_call_PrintChar('\n');
+}
+
+int
+main()
+{
+    int faults, ticks, i;
+
+    if (system_call_Madvise((unsigned)hot, sizeof(hot), MADV_LOCK) != 0) {
+        system_call_PrintString("MADV_LOCK failed\n");
+    }
+
+    faults = system_call_GetNumPageFaults();
+    ticks = system_call_GetTime();
+    Scan();
+    Report("No hint", system_call_GetNumPageFaults() - faults, system_call_GetTime() - ticks);
+
+    system_call_Madvise((unsigned)scan, sizeof(scan), MADV_DONTNEED);
+    system_call_Madvise((unsigned)scan, sizeof(scan), MADV_SEQUENTIAL);
+
+    faults = system_call_GetNumPageFaults();
+    ticks = system_call_GetTime();
+    Scan();
+    Report("MADV_SEQUENTIAL", system_call_GetNumPageFaults() - faults, system_call_GetTime() - ticks);
+
+    system_call_Madvise((unsigned)scan, sizeof(scan), MADV_DONTNEED);
+    for (i = 0; i < SCAN_SIZE; i += STRIDE) {
+        if (scan[i] != 0) {
+            system_call_PrintString("MADV_DONTNEED left data behind\n");
+            break;
+        }
+    }
+
+    system_call_Madvise((unsigned)hot, sizeof(hot), MADV_UNLOCK);
+    return 0;
+}
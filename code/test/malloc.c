@@ -0,0 +1,145 @@
+/* malloc.c
+ *	A size-class allocator for user programs.
+ *
+ *	Small requests are rounded up to one of NUM_CLASSES power-of-two
+ *	sizes.  Each class keeps a free list of blocks of exactly that
+ *	size, so malloc and free are a list pop and push.  When a class
+ *	runs dry, a chunk of memory is taken from the kernel with
+ *	system_call_Sbrk and cut into blocks of that class.
+ *
+ *	Requests bigger than the largest class get their own Sbrk region
+ *	and are kept on a first-fit list when freed.
+ *
+ *	Every block is preceded by an 8-byte header holding its class
+ *	(or LARGE_CLASS) and its usable size.
+ */
+
+#include "syscall.h"
+#include "malloc.h"
+
+#define MIN_BLOCK	8		/* smallest class */
+#define NUM_CLASSES	9		/* 8, 16, ..., 2048 bytes */
+#define MAX_SMALL	(MIN_BLOCK << (NUM_CLASSES - 1))
+#define LARGE_CLASS	NUM_CLASSES
+#define CHUNK_SIZE	1024		/* bytes to Sbrk per class refill */
+
+typedef struct header {
+    unsigned int sizeClass;	/* size class, or LARGE_CLASS */
+    unsigned int size;		/* usable bytes after the header */
+} Header;
+
+typedef struct freeBlock {
+    struct freeBlock *next;
+} FreeBlock;
+
+static FreeBlock *freeList[NUM_CLASSES];
+static FreeBlock *largeList;
+
+/* Get memory from the kernel, keeping the break 8-byte aligned */
+static char *
+MoreCore(unsigned int size)
+{
+    int brk = system_call_Sbrk(0);
+
+    if (brk == -1) return 0;
+    if (brk & 7) {
+	if (system_call_Sbrk(8 - (brk & 7)) == -1) return 0;
+    }
+    brk = system_call_Sbrk((size + 7) & ~7);
+    if (brk == -1) return 0;
+    return (char *)brk;
+}
+
+static int
+SizeToClass(unsigned int size)
+{
+    int c = 0;
+    unsigned int blockSize = MIN_BLOCK;
+
+    while (blockSize < size) {
+	blockSize <<= 1;
+	c++;
+    }
+    return c;
+}
+
+/* Carve a fresh chunk into blocks of class "c" */
+static int
+Refill(int c)
+{
+    unsigned int blockSize = MIN_BLOCK << c;
+    unsigned int step = blockSize + sizeof(Header);
+    unsigned int chunk = (step > CHUNK_SIZE) ? step : CHUNK_SIZE;
+    char *p = MoreCore(chunk);
+    char *end;
+    Header *h;
+    FreeBlock *b;
+
+    if (p == 0) return 0;
+    for (end = p + chunk; p + step <= end; p += step) {
+	h = (Header *)p;
+	h->sizeClass = c;
+	h->size = blockSize;
+	b = (FreeBlock *)(h + 1);
+	b->next = freeList[c];
+	freeList[c] = b;
+    }
+    return 1;
+}
+
+static void *
+LargeAlloc(unsigned int size)
+{
+    FreeBlock *b, *prev = 0;
+    Header *h;
+
+    size = (size + 7) & ~7;
+    for (b = largeList; b != 0; prev = b, b = b->next) {
+	h = ((Header *)b) - 1;
+	if (h->size >= size) {
+	    if (prev == 0) largeList = b->next;
+	    else prev->next = b->next;
+	    return (void *)b;
+	}
+    }
+
+    h = (Header *)MoreCore(size + sizeof(Header));
+    if (h == 0) return 0;
+    h->sizeClass = LARGE_CLASS;
+    h->size = size;
+    return (void *)(h + 1);
+}
+
+void *
+malloc(unsigned int size)
+{
+    int c;
+    FreeBlock *b;
+
+    if (size == 0) size = 1;
+    if (size > MAX_SMALL) return LargeAlloc(size);
+
+    c = SizeToClass(size);
+    if ((freeList[c] == 0) && !Refill(c)) return 0;
+    b = freeList[c];
+    freeList[c] = b->next;
+    return (void *)b;
+}
+
+void
+free(void *ptr)
+{
+    Header *h;
+    FreeBlock *b = (FreeBlock *)ptr;
+
+    if (ptr == 0) return;
+    h = ((Header *)ptr) - 1;
+    if (h->sizeClass == LARGE_CLASS) {
+	b->next = largeList;
+	largeList = b;
+    }
+    else {
+	b->next = freeList[h->sizeClass];
+	freeList[h->sizeClass] = b;
+    }
+}
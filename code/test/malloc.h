@@ -0,0 +1,17 @@
+/* malloc.h
+ *	Dynamic memory allocation for user programs.
+ *
+ *	Link malloc.o after start.o.  Memory comes from the kernel through
+ *	system_call_Sbrk, in demand-zero pages.
+ */
+
+#ifndef MALLOC_H
+#define MALLOC_H
+
+/* Allocate "size" bytes, 8-byte aligned.  Returns 0 if the heap is full. */
+void *malloc(unsigned int size);
+
+/* Give back a block returned by malloc.  free(0) does nothing. */
+void free(void *ptr);
+
+#endif /* MALLOC_H */
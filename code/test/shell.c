@@ -26,10 +26,11 @@ main()
 
 	buffer[--i] = '\0';
 
-	/*if( i > 0 ) {
-		newProc = system_call_Exec(buffer);
-		system_call_Join(newProc);
-	}*/
+	if( i > 0 ) {
+		newProc = system_call_Spawn(buffer, 0);
+		if( newProc != -1 )
+			system_call_Join(newProc);
+	}
     }
 }
 
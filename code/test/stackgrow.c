@@ -0,0 +1,44 @@
+/* stackgrow.c
+ *	Exercises the demand-grown user stack.
+ *
+ *	Recurses with a frame of a few hundred bytes, so the stack has
+ *	to grow well past its initial reservation, and prints the page
+ *	faults that took.  Unless OVERFLOW is 0, a much deeper call
+ *	then overflows on purpose; the process should be killed with a
+ *	segmentation fault instead of scribbling over the heap.
+ */
+
+#include "syscall.h"
+
+#define FRAME_SIZE	256	/* bytes of locals per call */
+#define DEPTH		100	/* calls that fit in the stack */
+#define OVERFLOW	1	/* set to 0 to skip the overflow */
+
+int
+Recurse(int depth)
+{
+    char frame[FRAME_SIZE];
+    int i;
+
+    for (i = 0; i < FRAME_SIZE; i++) frame[i] = depth;
+    if (depth == 0) return frame[0];
+    return Recurse(depth - 1) + frame[FRAME_SIZE - 1];
+}
+
+int
+main()
+{
+    system_call_PrintString("Recursion result: ");
+    system_call_PrintInt(Recurse(DEPTH));
+    system_call_PrintChar('\n');
+    system_call_PrintString("Page faults: ");
+    system_call_PrintInt(system_call_GetNumPageFaults());
+    system_call_PrintChar('\n');
+
+    if (OVERFLOW) {
+        /* Far more than UserStackMaxSize: must end in a segfault */
+        Recurse(1000);
+        system_call_PrintString("Stack overflow was not caught!\n");
+    }
+    return 0;
+}
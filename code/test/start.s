@@ -274,6 +274,73 @@ system_call_ShmAllocate:
         j       $31
         .end system_call_ShmAllocate
 
+	.globl system_call_Sbrk
+	.ent	system_call_Sbrk
+system_call_Sbrk:
+	addiu $2,$0,SYScall_Sbrk
+	syscall
+	j	$31
+	.end system_call_Sbrk
+
+	.globl system_call_Madvise
+	.ent	system_call_Madvise
+system_call_Madvise:
+	addiu $2,$0,SYScall_Madvise
+	syscall
+	j	$31
+	.end system_call_Madvise
+
+	.globl system_call_FutexWait
+	.ent	system_call_FutexWait
+system_call_FutexWait:
+	addiu $2,$0,SYScall_FutexWait
+	syscall
+	j	$31
+	.end system_call_FutexWait
+
+	.globl system_call_FutexWake
+	.ent	system_call_FutexWake
+system_call_FutexWake:
+	addiu $2,$0,SYScall_FutexWake
+	syscall
+	j	$31
+	.end system_call_FutexWake
+
+	.globl system_call_Spawn
+	.ent	system_call_Spawn
+system_call_Spawn:
+	addiu $2,$0,SYScall_Spawn
+	syscall
+	j	$31
+	.end system_call_Spawn
+
+	.globl system_call_ThreadCreate
+	.ent	system_call_ThreadCreate
+system_call_ThreadCreate:
+	la	$6,ThreadReturn		/* where the new thread's function */
+	addiu $2,$0,SYScall_ThreadCreate	/* returns to */
+	syscall
+	j	$31
+	.end system_call_ThreadCreate
+
+/* A thread made by system_call_ThreadCreate returns here from its
+ * function, and exits with the function's return value.
+ */
+	.ent	ThreadReturn
+ThreadReturn:
+	move	$4,$2
+	addiu $2,$0,SYScall_Exit
+	syscall
+	.end ThreadReturn
+
+	.globl system_call_GetNumPageFaults
+	.ent	system_call_GetNumPageFaults
+system_call_GetNumPageFaults:
+	addiu $2,$0,SYScall_NumPageFaults
+	syscall
+	j	$31
+	.end system_call_GetNumPageFaults
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
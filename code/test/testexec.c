@@ -1,10 +1,37 @@
 #include "syscall.h"
 
+/* Run with no arguments, Spawn a copy of this program and join it,
+ * then Exec another copy in place.  Each copy started with arguments
+ * prints them, with its pid: the spawned child has a pid of its own,
+ * the exec'd program keeps the original one.
+ */
+
+char *spawnArgs[] = { "testexec", "spawned", "child", 0 };
+char *execArgs[] = { "testexec", "exec'd", "in", "place", 0 };
+
 int
-main()
+main(int argc, char **argv)
 {
+    int i, child;
+
+    if (argc > 1) {
+       system_call_PrintString("[pid ");
+       system_call_PrintInt(system_call_GetPID());
+       system_call_PrintString("] argc=");
+       system_call_PrintInt(argc);
+       for (i=0; i<argc; i++) {
+          system_call_PrintChar(' ');
+          system_call_PrintString(argv[i]);
+       }
+       system_call_PrintChar('\n');
+       return 0;
+    }
+
+    child = system_call_Spawn("../test/testexec", spawnArgs);
+    system_call_Join(child);
+
     system_call_PrintString("Before calling Exec.\n");
-    system_call_Exec("../test/vectorsum");
+    system_call_Exec("../test/testexec", execArgs);
     system_call_PrintString("Returned from Exec.\n"); // Should never return
     return 0;
 }
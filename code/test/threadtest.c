@@ -0,0 +1,50 @@
+#include "syscall.h"
+
+#define NUM_THREADS 4
+#define SIZE 400
+
+/* Threads of one program sum parts of a shared array into a shared
+ * result array; each exits with its part's sum too, which Join hands
+ * back.  A forked child would write into a copy instead.
+ */
+
+int array[SIZE];
+int partial[NUM_THREADS];
+
+int
+Worker (int which)
+{
+    int i, sum = 0;
+
+    for (i=which*(SIZE/NUM_THREADS); i<(which+1)*(SIZE/NUM_THREADS); i++) {
+       sum += array[i];
+       if (i % 25 == 0) system_call_Yield();
+    }
+    partial[which] = sum;
+    return sum;
+}
+
+int
+main()
+{
+    int tid[NUM_THREADS];
+    int i, shared = 0, joined = 0;
+
+    for (i=0; i<SIZE; i++) array[i] = i;
+    for (i=0; i<NUM_THREADS; i++) {
+       tid[i] = system_call_ThreadCreate(Worker, i);
+    }
+    for (i=0; i<NUM_THREADS; i++) {
+       joined += system_call_Join(tid[i]);
+       shared += partial[i];
+    }
+
+    system_call_PrintString("Sum from Join: ");
+    system_call_PrintInt(joined);
+    system_call_PrintString(", from shared memory: ");
+    system_call_PrintInt(shared);
+    system_call_PrintString(" (expected ");
+    system_call_PrintInt(SIZE*(SIZE-1)/2);
+    system_call_PrintString(")\n");
+    return 0;
+}
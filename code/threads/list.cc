@@ -161,6 +161,21 @@ List::IsEmpty()
 	return FALSE; 
 }
 
+//----------------------------------------------------------------------
+// List::Length
+//      Returns the number of items on the list.
+//----------------------------------------------------------------------
+
+int
+List::Length()
+{
+    int count = 0;
+
+    for (ListElement *ptr = first; ptr != NULL; ptr = ptr->next)
+        count++;
+    return count;
+}
+
 //----------------------------------------------------------------------
 // List::SortedInsert
 //      Insert an "item" into a list, so that the list elements are
@@ -252,16 +267,15 @@ List::GetMinPriorityThread (void)
         first = NULL;
         last = NULL;
     } else {
-        minimum = ((NachOSThread*)(minptr->item))->GetPriority();
+        minimum = ((NachOSThread*)(minptr->item))->GetEffectivePriority();
         for (ptr = first->next, prev = first; ptr != NULL; prev = ptr, ptr = ptr->next) {
-           if (((NachOSThread*)(ptr->item))->GetPriority() < minimum) {
+           if (((NachOSThread*)(ptr->item))->GetEffectivePriority() < minimum) {
               minptr = ptr;
               minprev = prev;
-              minimum = ((NachOSThread*)(minptr->item))->GetPriority();
+              minimum = ((NachOSThread*)(minptr->item))->GetEffectivePriority();
            }
         }
         ASSERT(minptr != NULL);
-        ASSERT(minimum == ((NachOSThread*)(minptr->item))->GetPriority());
         thing = minptr->item;
         if (minprev == NULL) { // First element has minimum priority
            first = first->next;
@@ -279,3 +293,16 @@ List::GetMinPriorityThread (void)
     delete minptr;
     return thing;
 }
+
+int
+List::GetMinEffectivePriority (int bound)
+{
+   ListElement *ptr;
+   int priority;
+
+   for (ptr = first; ptr != NULL; ptr = ptr->next) {
+      priority = ((NachOSThread*)(ptr->item))->GetEffectivePriority();
+      if (priority < bound) bound = priority;
+   }
+   return bound;
+}
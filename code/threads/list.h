@@ -52,6 +52,7 @@ class List {
     void Mapcar(VoidFunctionPtr func);	// Apply "func" to every element 
 					// on the list
     bool IsEmpty();		// is the list empty? 
+    int Length();		// number of items on the list
     
 
     // Routines to put/get items on/off list in order (sorted by key)
@@ -59,6 +60,9 @@ class List {
     void *SortedRemove(int *keyPtr); 	  	// Remove first item from list
 
     void *GetMinPriorityThread (void);
+    int GetMinEffectivePriority (int bound);	// best effective priority
+						// of the threads on the
+						// list, or bound if better
 
   private:
     ListElement *first;  	// Head of the list, NULL if list is empty
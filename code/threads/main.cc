@@ -15,15 +15,47 @@
 //              -n <network reliability> -m <machine id>
 //              -o <other machine id>
 //              -z
+//       nachos -sweep <jobs file> [<host threads>]
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -cpus simulates a multiprocessor with that many CPUs (default 1)
+//    -record <log> logs console input, network packets and random
+//		numbers as they are taken in (see replay.h)
+//    -replay <log> takes them from the log instead, reading no
+//		keyboard and opening no sockets
 //    -z prints the copyright message
+//    -sweep <jobs file> [<host threads>] runs one simulation per line of
+//		the jobs file, in parallel, and prints their statistics
+//		(must be the first flag; see sweep.h)
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
 //    -x runs a user program
+//    -T selects the page table: 0 flat (default), 1 two-level
+//    -ps sets the page size in bytes (a power of two; default 128)
+//    -lp maps code and data with large pages where possible
+//    -icache <bytes> <line bytes> <ways> <miss ticks> models an
+//		instruction cache
+//    -dcache <bytes> <line bytes> <ways> <miss ticks> models a data cache
+//    -pipe models pipeline stalls, with a branch predictor: 0 static,
+//		1 bimodal, 2 gshare
+//    -bpsize sets the number of predictor counters (default 1024)
+//    -bppenalty sets the ticks lost on a misprediction (default 2)
 //    -c tests the console
+//    -ckpt <tick> <file> saves the simulation to the file at the first
+//		system call from that tick on where it is safe (see
+//		checkpoint.h)
+//    -restore <file> carries on with a saved simulation; -A and -R
+//		given before it replace the saved policies
+//    -branch <tick or @syscall> <policies> carries the simulation on
+//		under each policy in a host process of its own, and
+//		compares them (see branch.h)
+//
+//  USE_TLB
+//    -tlb sets the number of TLB entries (default 4)
+//    -tlbways sets the entries per TLB set (default: fully associative)
+//    -tlbrepl sets the TLB replacement: 0 LRU, 1 FIFO, 2 random
 //
 //  FILESYS
 //    -f causes the physical disk to be formatted
@@ -52,24 +84,24 @@
 
 #include "utility.h"
 #include "system.h"
+#include "sweep.h"
+#ifdef USER_PROGRAM
+#include "checkpoint.h"
+#endif
 
 
 // External functions used by this file
 
 extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
 extern void Print(char *file), PerformanceTest(void);
-extern void StartUserProcess(char *file), ConsoleTest(char *in, char *out);
+extern void StartUserProcess(char *file), ConsoleTest();
 extern void MailTest(int networkID);
 
 extern void ReadInputAndFork(char *file);
 
 //----------------------------------------------------------------------
 // main
-// 	Bootstrap the operating system kernel.
-//
-//	Check command line arguments
-//	Initialize data structures
-//	(optionally) Call test procedure
+// 	Run one simulation, or with -sweep, a batch of them.
 //
 //	"argc" is the number of command line arguments (including the name
 //		of the command) -- ex: "nachos -d +" -> argc = 3
@@ -79,11 +111,33 @@ extern void ReadInputAndFork(char *file);
 
 int
 main(int argc, char **argv)
+{
+    if ((argc > 2) && !strcmp(argv[1], "-sweep"))
+	return RunSweep(argv[2], (argc > 3) ? atoi(argv[3]) : 1);
+    return NachosMain(argc, argv);
+}
+
+//----------------------------------------------------------------------
+// NachosMain
+// 	Bootstrap the operating system kernel.
+//
+//	Check command line arguments
+//	Initialize data structures
+//	(optionally) Call test procedure
+//
+//	Called by main, or by the sweep driver once per simulation.
+//----------------------------------------------------------------------
+
+int
+NachosMain(int argc, char **argv)
 {
     int argCount;			// the number of arguments
 					// for a particular command
 
     int schedPriority = MAX_NICE_PRIORITY;
+#ifdef USER_PROGRAM
+    bool algoGiven = FALSE, replGiven = FALSE;	// -A, -R seen (for -restore)
+#endif
 
     DEBUG('t', "Entering main");
     (void) Initialize(argc, argv);
@@ -102,6 +156,7 @@ main(int argc, char **argv)
            schedulingAlgo = atoi(*(argv + 1));
            argCount = 2;
            ASSERT((schedulingAlgo > 0) && (schedulingAlgo <= 4));
+           algoGiven = TRUE;
            if ((schedulingAlgo == ROUND_ROBIN) || (schedulingAlgo == UNIX_SCHED)) {
               ASSERT (SCHED_QUANTUM > 0);
            }
@@ -114,6 +169,11 @@ main(int argc, char **argv)
            replacementAlgo = atoi(*(argv + 1));
            argCount = 2;
            ASSERT((replacementAlgo > 0) && (replacementAlgo <= 4));
+           replGiven = TRUE;
+        } else if (!strcmp(*argv, "-T")) {
+           pageTableType = atoi(*(argv + 1));
+           argCount = 2;
+           ASSERT((pageTableType == FLAT_PAGE_TABLE) || (pageTableType == TWO_LEVEL_PAGE_TABLE));
         } else if (!strcmp(*argv, "-P")) {
             schedPriority = atoi(*(argv + 1));
             argCount = 2;
@@ -126,13 +186,11 @@ main(int argc, char **argv)
             StartUserProcess(*(argv + 1));
             argCount = 2;
         } else if (!strcmp(*argv, "-c")) {      // test the console
-	    if (argc == 1)
-	        ConsoleTest(NULL, NULL);
-	    else {
-		ASSERT(argc > 2);
-	        ConsoleTest(*(argv + 1), *(argv + 2));
+	    if (argc > 1) {		// Initialize opened the console
+		ASSERT(argc > 2);	// on these files
 	        argCount = 3;
 	    }
+	    ConsoleTest();
 	    interrupt->Halt();		// once we start the console, then
 					// Nachos will loop forever waiting
 					// for console input
@@ -140,6 +198,10 @@ main(int argc, char **argv)
             ASSERT (argc > 1);
             ReadInputAndFork(*(argv + 1));
             argCount = 2;
+        } else if (!strcmp(*argv, "-restore")) {	// resume a checkpoint
+            ASSERT (argc > 1);
+            RestoreCheckpoint(*(argv + 1), algoGiven, replGiven);
+            argCount = 2;
         }
 #endif // USER_PROGRAM
 #ifdef FILESYS
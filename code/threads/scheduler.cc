@@ -22,25 +22,64 @@
 #include "scheduler.h"
 #include "system.h"
 
+//----------------------------------------------------------------------
+// CPUState::CPUState
+// 	Initialize an idle CPU with an empty run queue.
+//----------------------------------------------------------------------
+
+CPUState::CPUState(int _id)
+{
+    id = _id;
+    current = NULL;
+    readyList = new List;
+    sliceTicks = 0;
+    userTicks = dispatches = steals = 0;
+}
+
+CPUState::~CPUState()
+{
+    delete readyList;
+}
+
+//----------------------------------------------------------------------
+// CPUState::Print
+// 	Print what this CPU did, at shutdown.
+//----------------------------------------------------------------------
+
+void
+CPUState::Print()
+{
+    printf("CPU %d: user instructions %d, threads dispatched %d, stolen %d\n",
+	   id, userTicks, dispatches, steals);
+}
+
 //----------------------------------------------------------------------
 // NachOSscheduler::NachOSscheduler
-// 	Initialize the list of ready but not running threads to empty.
+// 	Initialize the list of ready but not running threads to empty,
+//	for each of the numCPUs CPUs.
 //----------------------------------------------------------------------
 
 NachOSscheduler::NachOSscheduler()
 { 
-    readyThreadList = new List;
+    int i;
+
+    ASSERT((numCPUs >= 1) && (numCPUs <= MaxCPUs));
+    for (i = 0; i < numCPUs; i++)
+        cpus[i] = new CPUState(i);
     empty_ready_queue_start_time = -1;
 } 
 
 //----------------------------------------------------------------------
 // NachOSscheduler::~NachOSscheduler
-// 	De-allocate the list of ready threads.
+// 	De-allocate the lists of ready threads.
 //----------------------------------------------------------------------
 
 NachOSscheduler::~NachOSscheduler()
 { 
-    delete readyThreadList; 
+    int i;
+
+    for (i = 0; i < numCPUs; i++)
+        delete cpus[i];
 } 
 
 //----------------------------------------------------------------------
@@ -78,11 +117,53 @@ NachOSscheduler::ThreadIsReadyToRun (NachOSThread *thread)
     }
     thread->setStatus(READY);
     thread->SetWaitStartTime(stats->totalTicks);
-    if (readyThreadList->IsEmpty() && (empty_ready_queue_start_time != -1)) {
+    if (AllQueuesEmpty() && (empty_ready_queue_start_time != -1)) {
        stats->empty_ready_queue_time += (stats->totalTicks - empty_ready_queue_start_time);
        empty_ready_queue_start_time = -1;
     }
-    readyThreadList->Append((void *)thread);
+    cpus[QueueFor(thread)]->readyList->Append((void *)thread);
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::QueueFor
+// 	Choose the run queue for a thread that became ready: the one of
+//	the CPU it last ran on, or for a new thread, the CPU with the
+//	least work.
+//----------------------------------------------------------------------
+
+int
+NachOSscheduler::QueueFor (NachOSThread *thread)
+{
+    int i, load, best = 0, bestLoad = -1;
+
+    if (thread->GetCPU() != -1)
+       return thread->GetCPU();
+
+    for (i = 0; i < numCPUs; i++) {
+       load = cpus[i]->readyList->Length() + ((cpus[i]->current != NULL) ? 1 : 0);
+       if ((bestLoad == -1) || (load < bestLoad)) {
+          best = i;
+          bestLoad = load;
+       }
+    }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::AllQueuesEmpty
+// 	Is there no ready thread on any CPU?
+//----------------------------------------------------------------------
+
+bool
+NachOSscheduler::AllQueuesEmpty ()
+{
+    int i;
+
+    for (i = 0; i < numCPUs; i++) {
+       if (!cpus[i]->readyList->IsEmpty())
+          return FALSE;
+    }
+    return TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -96,6 +177,36 @@ NachOSscheduler::ThreadIsReadyToRun (NachOSThread *thread)
 NachOSThread *
 NachOSscheduler::FindNextThreadToRun ()
 {
+    NachOSThread *thread = TakeFrom(currentCPU);
+    int i, victim = -1;
+
+    if ((thread == NULL) && (numCPUs > 1)) {
+       // Our queue is empty: steal from the longest queue
+       for (i = 0; i < numCPUs; i++) {
+          if ((i != currentCPU) && !cpus[i]->readyList->IsEmpty() &&
+              ((victim == -1) ||
+               (cpus[i]->readyList->Length() > cpus[victim]->readyList->Length())))
+             victim = i;
+       }
+       if (victim != -1) {
+          thread = TakeFrom(victim);
+          cpus[currentCPU]->steals++;
+       }
+    }
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::TakeFrom
+// 	Dequeue the thread the scheduling algorithm would run next from
+//	the run queue of "cpu", or return NULL if it is empty.
+//----------------------------------------------------------------------
+
+NachOSThread *
+NachOSscheduler::TakeFrom (int cpu)
+{
+    List *readyThreadList = cpus[cpu]->readyList;
+
     if ((schedulingAlgo == UNIX_SCHED) || (schedulingAlgo == NON_PREEMPTIVE_SJF)){
        return (NachOSThread *)readyThreadList->GetMinPriorityThread();
     }
@@ -123,9 +234,18 @@ NachOSscheduler::Schedule (NachOSThread *nextThread)
 {
     NachOSThread *oldThread = currentThread;
     
-    cpu_burst_start_time = stats->totalTicks;
-    nextThread->SetCPUBurstStartTime(cpu_burst_start_time);
-    stats->total_wait_time += (stats->totalTicks - nextThread->GetWaitStartTime());
+    if (nextThread->getStatus() == RUNNING) {
+       // Only with -cpus: nextThread was waiting for its CPU's turn,
+       // and carries on with its burst
+       cpu_burst_start_time = nextThread->GetCPUBurstStartTime();
+    }
+    else {
+       cpu_burst_start_time = stats->totalTicks;
+       nextThread->SetCPUBurstStartTime(cpu_burst_start_time);
+       stats->total_wait_time += (stats->totalTicks - nextThread->GetWaitStartTime());
+       cpus[currentCPU]->dispatches++;
+    }
+    SetRunningThread(nextThread);
 
 #ifdef USER_PROGRAM			// ignore until running user programs 
     if (currentThread->space != NULL) {	// if this thread is a user program,
@@ -142,6 +262,10 @@ NachOSscheduler::Schedule (NachOSThread *nextThread)
     
     DEBUG('t', "Switching from thread \"%s\" with pid %d to thread \"%s\" with pid %d\n",
 	  oldThread->getName(), oldThread->GetPID(), nextThread->getName(), nextThread->GetPID());
+
+#ifdef USE_TLB
+    machine->SelectTLB(currentCPU);	    // every CPU has its own TLB
+#endif
     
     // This is a machine-dependent assembly language routine defined 
     // in switch.s.  You may have to think
@@ -206,8 +330,166 @@ NachOSscheduler::Tail ()
 void
 NachOSscheduler::Print()
 {
+    int i;
+
     printf("Ready list contents:\n");
-    readyThreadList->Mapcar((VoidFunctionPtr) ThreadPrint);
+    for (i = 0; i < numCPUs; i++)
+       cpus[i]->readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::SetRunningThread
+// 	Record that "thread" now runs on the current CPU.
+//----------------------------------------------------------------------
+
+void
+NachOSscheduler::SetRunningThread (NachOSThread *thread)
+{
+    cpus[currentCPU]->current = thread;
+    thread->SetCPU(currentCPU);
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::LeaderCPU
+// 	The lowest numbered CPU that has a thread.  Its user ticks are
+//	the ones that move the simulated clock.
+//----------------------------------------------------------------------
+
+int
+NachOSscheduler::LeaderCPU ()
+{
+    int i;
+
+    for (i = 0; i < numCPUs; i++) {
+       if (cpus[i]->current != NULL)
+          return i;
+    }
+    return currentCPU;
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::CountUserTick
+// 	Called by Interrupt::OneTick for every user instruction.  Charges
+//	it to the current CPU, and returns TRUE if it should advance the
+//	simulated clock: the other CPUs run in the shadow of the leader.
+//----------------------------------------------------------------------
+
+bool
+NachOSscheduler::CountUserTick ()
+{
+    cpus[currentCPU]->userTicks++;
+    cpus[currentCPU]->sliceTicks++;
+    return MovesClock();
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::MovesClock
+// 	Is the current CPU the one whose time advances the simulated
+//	clock?  Always TRUE with a single CPU.  Pipeline stalls and cache
+//	misses are charged to the clock only when this is TRUE, as user
+//	ticks are.
+//----------------------------------------------------------------------
+
+bool
+NachOSscheduler::MovesClock ()
+{
+    return ((numCPUs == 1) || (currentCPU == LeaderCPU()));
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::TurnIsOver
+// 	Has the current CPU run for CPUSliceTicks since its turn began?
+//	Always FALSE with a single CPU.
+//----------------------------------------------------------------------
+
+bool
+NachOSscheduler::TurnIsOver ()
+{
+    return ((numCPUs > 1) && (cpus[currentCPU]->sliceTicks >= CPUSliceTicks));
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::SwitchCPU
+// 	End the current CPU's turn.  The next CPU, in round robin order,
+//	that has a thread or can find one in the run queues gets the
+//	turn.  The current thread stays on its CPU, and carries on
+//	when its CPU's turn comes again.
+//
+//	Called by Interrupt::OneTick, between two user instructions.
+//----------------------------------------------------------------------
+
+void
+NachOSscheduler::SwitchCPU ()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    NachOSThread *nextThread = NULL;
+    int i, myCPU = currentCPU;
+
+    cpus[myCPU]->sliceTicks = 0;
+    for (i = 1; (i < numCPUs) && (nextThread == NULL); i++) {
+       currentCPU = (myCPU + i) % numCPUs;
+       nextThread = cpus[currentCPU]->current;
+       if (nextThread == NULL)			// idle: look for work
+          nextThread = FindNextThreadToRun();
+    }
+    if (nextThread == NULL) {			// nobody else can run
+       currentCPU = myCPU;
+       (void) interrupt->SetLevel(oldLevel);
+       return;
+    }
+
+    DEBUG('t', "CPU %d hands over to CPU %d\n", myCPU, currentCPU);
+    Schedule(nextThread);
+
+    // Our CPU has its turn again.  Its time slice may have run out
+    // while the other CPUs had theirs.
+    if (((schedulingAlgo == ROUND_ROBIN) || (schedulingAlgo == UNIX_SCHED)) &&
+        ((stats->totalTicks - cpu_burst_start_time) >= SCHED_QUANTUM)) {
+       currentThread->YieldCPU();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::ResumeOtherCPU
+// 	The current thread is blocking and the current CPU found nothing
+//	to run, so the CPU goes idle.  Returns the thread of another
+//	busy CPU, which now gets the turn, or NULL if every CPU is idle.
+//----------------------------------------------------------------------
+
+NachOSThread *
+NachOSscheduler::ResumeOtherCPU ()
+{
+    int i, myCPU = currentCPU;
+
+    if (numCPUs == 1)
+       return NULL;
+
+    cpus[myCPU]->current = NULL;
+    cpus[myCPU]->sliceTicks = 0;
+    for (i = 1; i < numCPUs; i++) {
+       if (cpus[(myCPU + i) % numCPUs]->current != NULL) {
+          currentCPU = (myCPU + i) % numCPUs;
+          return cpus[currentCPU]->current;
+       }
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::PrintCPUStats
+// 	Print the per-CPU statistics, when there is more than one CPU.
+//----------------------------------------------------------------------
+
+void
+NachOSscheduler::PrintCPUStats ()
+{
+    int i;
+
+    if (numCPUs == 1)
+       return;
+    for (i = 0; i < numCPUs; i++)
+       cpus[i]->Print();
 }
 
 void
@@ -249,3 +531,62 @@ NachOSscheduler::UpdateThreadPriority (void)
       }
    }
 }
+
+#ifdef USER_PROGRAM
+#include "checkpoint.h"
+
+//----------------------------------------------------------------------
+// NachOSscheduler::Checkpoint
+// 	Save what each CPU is running, its counters and its run queue,
+//	by pid.  Each queue is rotated once, so it ends up as it was.
+//----------------------------------------------------------------------
+
+void
+NachOSscheduler::Checkpoint(CheckpointFile *file)
+{
+    NachOSThread *thread;
+    int i, j;
+
+    file->WriteInt(empty_ready_queue_start_time);
+    for (i = 0; i < numCPUs; i++) {
+       file->WriteInt((cpus[i]->current != NULL) ? cpus[i]->current->GetPID() : -1);
+       file->WriteInt(cpus[i]->sliceTicks);
+       file->WriteInt(cpus[i]->userTicks);
+       file->WriteInt(cpus[i]->dispatches);
+       file->WriteInt(cpus[i]->steals);
+       file->WriteInt(cpus[i]->readyList->Length());
+       for (j = cpus[i]->readyList->Length(); j > 0; j--) {
+          thread = (NachOSThread *)cpus[i]->readyList->Remove();
+          file->WriteInt(thread->GetPID());
+          cpus[i]->readyList->Append((void *)thread);
+       }
+    }
+}
+
+//----------------------------------------------------------------------
+// NachOSscheduler::Restore
+// 	Read back what Checkpoint saved.  The threads must already have
+//	been restored, under their old pids.
+//----------------------------------------------------------------------
+
+void
+NachOSscheduler::Restore(CheckpointFile *file)
+{
+    int i, j, pid;
+
+    empty_ready_queue_start_time = file->ReadInt();
+    for (i = 0; i < numCPUs; i++) {
+       pid = file->ReadInt();
+       cpus[i]->current = (pid != -1) ? threadArray[pid] : NULL;
+       cpus[i]->sliceTicks = file->ReadInt();
+       cpus[i]->userTicks = file->ReadInt();
+       cpus[i]->dispatches = file->ReadInt();
+       cpus[i]->steals = file->ReadInt();
+       for (j = file->ReadInt(); j > 0; j--) {
+          pid = file->ReadInt();
+          ASSERT(threadArray[pid] != NULL);
+          cpus[i]->readyList->Append((void *)threadArray[pid]);
+       }
+    }
+}
+#endif
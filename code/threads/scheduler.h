@@ -13,6 +13,40 @@
 #include "list.h"
 #include "thread.h"
 
+#define MaxCPUs		8	// most CPUs that -cpus can simulate
+#define CPUSliceTicks	10	// user ticks a CPU runs before the next
+				// CPU gets its turn
+
+// With -cpus N the machine has N CPUs.  The host still runs one
+// thread at a time, so the CPUs take turns: each runs CPUSliceTicks
+// user instructions, then the next busy CPU resumes where it left
+// off.  Only the lowest numbered busy CPU advances the simulated
+// clock for user instructions, so N busy CPUs get through N times
+// the work in the same simulated time.  Kernel code is serialized,
+// as if under one big lock, and is charged as usual.
+//
+// Each CPU has its own run queue.  A thread goes back to the queue
+// of the CPU it last ran on; a new thread goes to the least loaded
+// CPU.  A CPU whose queue is empty steals from the longest queue.
+
+class CPUState {
+  public:
+    CPUState(int id);
+    ~CPUState();
+
+    void Print();		// Print the per-CPU statistics
+
+    int id;
+    NachOSThread *current;	// thread running on this CPU (possibly
+				// waiting for its turn), NULL if idle
+    List *readyList;		// this CPU's run queue
+    int sliceTicks;		// user ticks run in the current turn
+
+    int userTicks;		// user instructions executed
+    int dispatches;		// threads started on this CPU
+    int steals;			// threads taken from other run queues
+};
+
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
@@ -26,17 +60,44 @@ class NachOSscheduler {
     NachOSThread* FindNextThreadToRun();		// Dequeue first thread on the ready 
 					// list, if any, and return thread.
     void Schedule(NachOSThread* nextThread);	// Cause nextThread to start running
+    void SetRunningThread(NachOSThread* thread);	// thread runs on the
+						// current CPU
     void Print();			// Print contents of ready list
 
+    // Used by the SMP mode (-cpus)
+    bool CountUserTick();		// Returns TRUE if this user tick
+					// advances the simulated clock
+    bool MovesClock();			// Does time spent on the current
+					// CPU advance the simulated clock?
+    bool TurnIsOver();			// Has the current CPU used up
+					// its turn?
+    void SwitchCPU();			// Give the next busy CPU its turn
+    NachOSThread* ResumeOtherCPU();	// The current CPU goes idle;
+					// returns the thread of another
+					// busy CPU to resume, or NULL
+    void PrintCPUStats();
+
     void Tail();			// Used by fork()
 
     void SetEmptyReadyQueueStartTime (int ticks);
 
     void UpdateThreadPriority (void);	// Used by the UNIX scheduler
+
+#ifdef USER_PROGRAM
+    void Checkpoint(CheckpointFile *file);	// Save the run queues
+    void Restore(CheckpointFile *file);		// ... and put the restored
+						// threads back on them
+#endif
    
   private:
-    List *readyThreadList;  		// queue of threads that are ready to run,
-				// but not running
+    NachOSThread* TakeFrom(int cpu);	// Dequeue from cpu's run queue
+    int QueueFor(NachOSThread* thread);	// Which run queue thread goes to
+    bool AllQueuesEmpty();
+    int LeaderCPU();			// lowest numbered busy CPU
+
+    CPUState *cpus[MaxCPUs];		// per-CPU state; cpus[i]->readyList
+					// is the queue of threads that are
+					// ready to run, but not running
 
     int empty_ready_queue_start_time;
 };
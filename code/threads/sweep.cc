@@ -0,0 +1,209 @@
+// sweep.cc
+//	Routines to run a batch of independent simulations on a pool of
+//	host threads.  See sweep.h.
+//
+//	A host thread runs a simulation by calling NachosMain, exactly
+//	as main does for a single one.  The simulation ends in Cleanup,
+//	which would normally exit the process; instead it calls
+//	EndOfSimulation, which records the statistics and longjmps back
+//	to the host thread's loop to pick up the next job.  Whatever
+//	the simulation allocated and did not free is left behind.
+//
+//	A simulation that fails an ASSERT still aborts the whole
+//	process.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "sweep.h"
+
+#include <pthread.h>
+#include <setjmp.h>
+
+// One simulation, and what it measured
+
+class SweepJob {
+  public:
+    char *line;				// the jobs file line, for printing
+    int argc;
+    char *argv[MaxSweepArgs + 1];	// argv[0] is "nachos"
+
+    SweepResult result;
+};
+
+static SweepJob jobs[MaxSweepJobs];
+static int numJobs;
+static int nextJob;			// next job not yet started
+static pthread_mutex_t jobsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static SimulationLocal SweepJob *runningJob;	// this host thread's job
+static SimulationLocal jmp_buf simulationDone;
+
+//----------------------------------------------------------------------
+// SweepResult::Record
+// 	Copy out the statistics of this host thread's simulation, which
+//	has just halted.
+//----------------------------------------------------------------------
+
+void
+SweepResult::Record()
+{
+    totalTicks = stats->totalTicks;
+    userTicks = stats->userTicks;
+    systemTicks = stats->systemTicks;
+    idleTicks = stats->idleTicks;
+    cpuTime = stats->cpu_time;
+    waitTime = stats->total_wait_time;
+    numPageFaults = stats->numPageFaults;
+    numSwitches = stats->preemptive_switch + stats->nonpreemptive_switch;
+    finished = TRUE;
+}
+
+//----------------------------------------------------------------------
+// PrintSweepHeader, PrintSweepRow
+// 	Print the table of results, one simulation per row.  "label"
+//	says what the simulation was.
+//----------------------------------------------------------------------
+
+void
+PrintSweepHeader()
+{
+    printf("%4s %10s %10s %10s %10s %10s %10s %7s %8s  %s\n", "job",
+	   "total", "user", "system", "idle", "cpu busy", "wait", "faults",
+	   "switches", "arguments");
+}
+
+void
+PrintSweepRow(int row, SweepResult *r, char *label)
+{
+    if (!r->finished) {
+	printf("%4d %s  %s\n", row, "did not finish", label);
+	return;
+    }
+    printf("%4d %10d %10d %10d %10d %10d %10d %7d %8d  %s\n", row,
+	   r->totalTicks, r->userTicks, r->systemTicks, r->idleTicks,
+	   r->cpuTime, r->waitTime, r->numPageFaults, r->numSwitches, label);
+}
+
+//----------------------------------------------------------------------
+// EndOfSimulation
+// 	Called by Cleanup in place of exiting, once the simulation has
+//	halted.  Copy out the statistics, and return to SweepWorker.
+//----------------------------------------------------------------------
+
+static void
+EndOfSimulation()
+{
+    runningJob->result.Record();
+    longjmp(simulationDone, 1);
+}
+
+//----------------------------------------------------------------------
+// SweepWorker
+// 	Body of each host thread: run jobs until there are none left.
+//----------------------------------------------------------------------
+
+static void *
+SweepWorker(void *dummy)
+{
+    for (;;) {
+	pthread_mutex_lock(&jobsLock);
+	if (nextJob == numJobs) {
+	    pthread_mutex_unlock(&jobsLock);
+	    return NULL;
+	}
+	runningJob = &jobs[nextJob++];
+	pthread_mutex_unlock(&jobsLock);
+
+	endSimulation = EndOfSimulation;
+	if (setjmp(simulationDone) == 0)
+	    NachosMain(runningJob->argc, runningJob->argv);	// not reached
+    }
+}
+
+//----------------------------------------------------------------------
+// ReadJobs
+// 	Split each line of "jobsFile" into an argument list.  Returns
+//	the number of jobs.
+//----------------------------------------------------------------------
+
+static int
+ReadJobs(char *jobsFile)
+{
+    FILE *fp = fopen(jobsFile, "r");
+    char buffer[1024];
+    char *arg, *rest;
+    SweepJob *job;
+
+    if (fp == NULL) {
+	fprintf(stderr, "Unable to open sweep jobs file %s\n", jobsFile);
+	return 0;
+    }
+    numJobs = 0;
+    while (fgets(buffer, sizeof(buffer), fp) != NULL) {
+	buffer[strcspn(buffer, "\r\n")] = '\0';
+	arg = buffer + strspn(buffer, " \t");
+	if ((*arg == '\0') || (*arg == '#'))
+	    continue;
+	ASSERT(numJobs < MaxSweepJobs);
+	job = &jobs[numJobs++];
+	job->line = strdup(arg);
+	job->argv[0] = "nachos";
+	job->argc = 1;
+	for (arg = strtok_r(buffer, " \t", &rest); arg != NULL;
+				arg = strtok_r(NULL, " \t", &rest)) {
+	    ASSERT(job->argc < MaxSweepArgs);
+	    job->argv[job->argc++] = strdup(arg);
+	}
+	job->argv[job->argc] = NULL;
+	job->result.finished = FALSE;
+    }
+    fclose(fp);
+    return numJobs;
+}
+
+//----------------------------------------------------------------------
+// RunSweep
+// 	Run every simulation listed in "jobsFile" on "numHostThreads"
+//	host threads, then print their statistics side by side.
+//	Returns the process exit status.
+//----------------------------------------------------------------------
+
+int
+RunSweep(char *jobsFile, int numHostThreads)
+{
+    pthread_t workers[MaxSweepThreads];
+    pthread_attr_t attr;
+    int i, err;
+
+    if (ReadJobs(jobsFile) == 0)
+	return 1;
+    if (numHostThreads < 1)
+	numHostThreads = 1;
+    if (numHostThreads > MaxSweepThreads)
+	numHostThreads = MaxSweepThreads;
+    if (numHostThreads > numJobs)
+	numHostThreads = numJobs;
+
+    nextJob = 0;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 8 * 1024 * 1024);	// the main Nachos
+							// thread runs here
+    for (i = 0; i < numHostThreads; i++) {
+	err = pthread_create(&workers[i], &attr, SweepWorker, NULL);
+	ASSERT(err == 0);
+    }
+    for (i = 0; i < numHostThreads; i++)
+	pthread_join(workers[i], NULL);
+    pthread_attr_destroy(&attr);
+
+    printf("\nSweep: %d simulations on %d host threads\n", numJobs,
+	   numHostThreads);
+    PrintSweepHeader();
+    for (i = 0; i < numJobs; i++)
+	PrintSweepRow(i, &jobs[i].result, jobs[i].line);
+    return 0;
+}
@@ -0,0 +1,55 @@
+// sweep.h
+//	Interface to the sweep driver, which runs many independent
+//	simulations, each with its own command line, in parallel on a
+//	pool of host threads, and prints one table of their statistics.
+//
+//	  nachos -sweep <jobs file> [<host threads>]
+//
+//	Each non-empty line of the jobs file not starting with '#' is
+//	the argument list of one simulation, as it would be given to
+//	nachos, e.g.  "-A 2 -F batch1 -rs 7".
+//
+//	All kernel state is SimulationLocal (see utility.h), so each
+//	host thread has a machine, scheduler, statistics and random
+//	number generator of its own.  The simulations only share the
+//	host's files and standard output.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "copyright.h"
+
+#define MaxSweepJobs	256		// simulations in one jobs file
+#define MaxSweepArgs	64		// arguments of one simulation
+#define MaxSweepThreads	64		// host threads in the pool
+
+// What one simulation measured, for the table
+
+class SweepResult {
+  public:
+    void Record();			// Copy from the statistics of the
+					// simulation that just ended
+
+    bool finished;			// did the simulation reach Cleanup?
+    int totalTicks, userTicks, systemTicks, idleTicks;
+    int cpuTime, waitTime;		// stats->cpu_time, total_wait_time
+    int numPageFaults;
+    int numSwitches;			// preemptive and not
+};
+
+extern void PrintSweepHeader();		// Print the column titles
+extern void PrintSweepRow(int row, SweepResult *result, char *label);
+					// ... and one simulation
+
+extern int NachosMain(int argc, char **argv);	// Run one simulation
+						// (main.cc)
+extern int RunSweep(char *jobsFile, int numHostThreads);
+						// Run every simulation in
+						// jobsFile, and print the
+						// results
+
+#endif // SWEEP_H
@@ -1,8 +1,7 @@
 // synch.cc 
 //	Routines for synchronizing threads.  Three kinds of
 //	synchronization routines are defined here: semaphores, locks 
-//   	and condition variables (the implementation of the last two
-//	are left to the reader).
+//   	and condition variables.
 //
 // Any implementation of a synchronization routine needs some
 // primitive atomic operation.  We assume Nachos is running on
@@ -25,6 +24,86 @@
 #include "synch.h"
 #include "system.h"
 
+//----------------------------------------------------------------------
+// HeldObject::HeldObject
+// 	Initialize an object that no one holds or waits for.
+//----------------------------------------------------------------------
+
+HeldObject::HeldObject()
+{
+    holder = NULL;
+    nextHeld = NULL;
+    queue = new List;
+}
+
+HeldObject::~HeldObject()
+{
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// HeldObject::Take
+// 	"thread" now holds the object: put it on the thread's list of
+//	held objects, whose waiters it inherits priority from.
+//----------------------------------------------------------------------
+
+void
+HeldObject::Take(NachOSThread *thread)
+{
+    ASSERT(holder == NULL);
+    holder = thread;
+    nextHeld = thread->heldObjects;
+    thread->heldObjects = this;
+}
+
+//----------------------------------------------------------------------
+// HeldObject::Drop
+// 	The holder lets go of the object, and with it the priority of
+//	the object's waiters.  The holder need not be the current thread:
+//	an interrupt handler may V a mutex semaphore.
+//----------------------------------------------------------------------
+
+void
+HeldObject::Drop()
+{
+    HeldObject **link;
+
+    if (holder == NULL)
+	return;				// the holder has finished
+    for (link = &holder->heldObjects; *link != this; link = &(*link)->nextHeld)
+	ASSERT(*link != NULL);
+    *link = nextHeld;
+    holder = NULL;
+    nextHeld = NULL;
+}
+
+//----------------------------------------------------------------------
+// HeldObject::WaitFor
+// 	Put the current thread to sleep on the queue.  If its priority
+//	is better than the holder's own, the holder runs with it for now,
+//	and the wait counts as a priority inversion.
+//----------------------------------------------------------------------
+
+void
+HeldObject::WaitFor()
+{
+    bool inverted = FALSE;
+    int start = stats->totalTicks;
+
+    if (((schedulingAlgo == UNIX_SCHED) || (schedulingAlgo == NON_PREEMPTIVE_SJF))
+		&& (holder != NULL) &&
+		(currentThread->GetEffectivePriority() < holder->GetPriority())) {
+	inverted = TRUE;
+	stats->priorityInversions++;
+	DEBUG('s', "\"%s\" waits on lower priority \"%s\"\n",
+	      currentThread->getName(), holder->getName());
+    }
+    queue->Append((void *)currentThread);
+    currentThread->PutThreadToSleep();
+    if (inverted)
+	stats->inversionTicks += stats->totalTicks - start;
+}
+
 //----------------------------------------------------------------------
 // Semaphore::Semaphore
 // 	Initialize a semaphore, so that it can be used for synchronization.
@@ -37,7 +116,7 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 {
     name = debugName;
     value = initialValue;
-    queue = new List;
+    isMutex = (initialValue == 1);
 }
 
 //----------------------------------------------------------------------
@@ -48,7 +127,7 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 
 Semaphore::~Semaphore()
 {
-    delete queue;
+    Drop();
 }
 
 //----------------------------------------------------------------------
@@ -66,12 +145,12 @@ Semaphore::P()
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
     
-    while (value == 0) { 			// semaphore not available
-	queue->Append((void *)currentThread);	// so go to sleep
-	currentThread->PutThreadToSleep();
-    } 
+    while (value == 0) 			// semaphore not available
+	WaitFor();				// so go to sleep
     value--; 					// semaphore available, 
 						// consume its value
+    if (isMutex && (value == 0))
+	Take(currentThread);
     
     (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
 }
@@ -94,19 +173,205 @@ Semaphore::V()
     if (thread != NULL)	   // make thread ready, consuming the V immediately
 	scheduler->ThreadIsReadyToRun(thread);
     value++;
+    if (isMutex)
+	Drop();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Semaphore::setValue
+// 	Set the value of the semaphore, and wake up as many of the
+//	threads waiting in P() as can now get past it.  They re-check
+//	the value when they run.
+//----------------------------------------------------------------------
+
+void
+Semaphore::setValue(int newValue)
+{
+    NachOSThread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int i;
+
+    ASSERT(newValue >= 0);
+    value = newValue;
+    if (isMutex && (value > 0))
+	Drop();
+    for (i = 0; i < value; i++) {
+	thread = (NachOSThread *)queue->Remove();
+	if (thread == NULL)
+	    break;
+	scheduler->ThreadIsReadyToRun(thread);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Lock::Lock
+// 	Initialize a lock, so that it can be used for synchronization.
+//	The lock starts out FREE.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Lock::Lock(char* debugName)
+{
+    name = debugName;
+    acquisitions = contended = waitTicks = 0;
+}
+
+//----------------------------------------------------------------------
+// Lock::~Lock
+// 	De-allocate a lock, when no longer needed.  It must be FREE.
+//----------------------------------------------------------------------
+
+Lock::~Lock()
+{
+    ASSERT((holder == NULL) && queue->IsEmpty());
+    DEBUG('s', "Lock \"%s\": %d acquisitions, %d contended, %d ticks waiting\n",
+	  name, acquisitions, contended, waitTicks);
+}
+
+//----------------------------------------------------------------------
+// Lock::Acquire
+// 	Wait until the lock is FREE, then take it.  A thread that finds
+//	the lock BUSY goes to sleep, and is woken up by Release once it
+//	has been made the owner.
+//----------------------------------------------------------------------
+
+void
+Lock::Acquire()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start;
+
+    ASSERT(!isHeldByCurrentThread());
+    acquisitions++;
+    if (holder == NULL) {
+	Take(currentThread);
+    } else {
+	contended++;
+	start = stats->totalTicks;
+	WaitFor();
+	ASSERT(holder == currentThread);	// handed over by Release
+	waitTicks += stats->totalTicks - start;
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Lock::Release
+// 	Give up the lock.  If anyone is waiting, the first waiter becomes
+//	the owner and is made ready to run; otherwise the lock is FREE.
+//----------------------------------------------------------------------
+
+void
+Lock::Release()
+{
+    NachOSThread *next;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(isHeldByCurrentThread());
+    Drop();
+    next = (NachOSThread *)queue->Remove();
+    if (next != NULL) {
+	Take(next);			// it inherits from the other waiters
+	scheduler->ThreadIsReadyToRun(next);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Lock::isHeldByCurrentThread
+// 	Is the running thread the owner of the lock?
+//----------------------------------------------------------------------
+
+bool
+Lock::isHeldByCurrentThread()
+{
+    return (holder == currentThread);
+}
+
+//----------------------------------------------------------------------
+// Condition::Condition
+// 	Initialize a condition variable, with no one waiting on it.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Condition::Condition(char* debugName)
+{
+    name = debugName;
+    queue = new List;
+}
+
+//----------------------------------------------------------------------
+// Condition::~Condition
+// 	De-allocate a condition variable.  Assume no one is still
+//	waiting on it!
+//----------------------------------------------------------------------
+
+Condition::~Condition()
+{
+    ASSERT(queue->IsEmpty());
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// Condition::Wait
+// 	Release "conditionLock" and sleep until signaled, then acquire
+//	the lock again.  With interrupts off, no Signal can slip in
+//	between releasing the lock and going to sleep.
+//
+//	Mesa semantics: another thread may get the lock first, so the
+//	caller must check its condition again when Wait returns.
+//----------------------------------------------------------------------
+
+void
+Condition::Wait(Lock* conditionLock)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    queue->Append((void *)currentThread);
+    conditionLock->Release();
+    currentThread->PutThreadToSleep();
+    conditionLock->Acquire();
     (void) interrupt->SetLevel(oldLevel);
 }
 
-// Dummy functions -- so we can compile our later assignments 
-// Note -- without a correct implementation of Condition::Wait(), 
-// the test case in the network assignment won't work!
-Lock::Lock(char* debugName) {}
-Lock::~Lock() {}
-void Lock::Acquire() {}
-void Lock::Release() {}
+//----------------------------------------------------------------------
+// Condition::Signal
+// 	Wake up the thread that has waited longest, if any.  It runs
+//	once it gets "conditionLock", which the caller holds.
+//----------------------------------------------------------------------
 
-Condition::Condition(char* debugName) { }
-Condition::~Condition() { }
-void Condition::Wait(Lock* conditionLock) { ASSERT(FALSE); }
-void Condition::Signal(Lock* conditionLock) { }
-void Condition::Broadcast(Lock* conditionLock) { }
+void
+Condition::Signal(Lock* conditionLock)
+{
+    NachOSThread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    thread = (NachOSThread *)queue->Remove();
+    if (thread != NULL)
+	scheduler->ThreadIsReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Condition::Broadcast
+// 	Wake up every thread waiting on the condition.  They line up
+//	for "conditionLock" in the order they waited.
+//----------------------------------------------------------------------
+
+void
+Condition::Broadcast(Lock* conditionLock)
+{
+    NachOSThread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    while ((thread = (NachOSThread *)queue->Remove()) != NULL)
+	scheduler->ThreadIsReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
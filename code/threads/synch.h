@@ -2,10 +2,7 @@
 //	Data structures for synchronizing threads.
 //
 //	Three kinds of synchronization are defined here: semaphores,
-//	locks, and condition variables.  The implementation for
-//	semaphores is given; for the latter two, only the procedure
-//	interface is given -- they are to be implemented as part of 
-//	the first assignment.
+//	locks, and condition variables.
 //
 //	Note that all the synchronization objects take a "name" as
 //	part of the initialization.  This is solely for debugging purposes.
@@ -22,6 +19,33 @@
 #include "list.h"
 #include "synchop.h"
 
+// Something a thread holds while other threads wait for it: a Lock,
+// or a Semaphore used as a mutex.  Under the priority schedulers
+// (SJF and UNIX) the holder inherits the best priority among the
+// waiters, and so on down a chain of holders that wait in turn; see
+// NachOSThread::GetEffectivePriority.  The priority is back to the
+// holder's own once it lets go of the object.
+//
+// A waiter with a better priority than the holder's own suffers a
+// priority inversion; Statistics counts them, and the ticks spent in
+// them.
+
+class HeldObject {
+  public:
+    HeldObject();
+    ~HeldObject();
+
+    NachOSThread *holder;		// NULL if no one holds it
+    HeldObject *nextHeld;		// next object its holder holds
+    List *queue;			// threads waiting for it, in order
+
+  protected:
+    void Take(NachOSThread *thread);	// thread now holds the object
+    void Drop();			// the holder lets go of it
+    void WaitFor();			// sleep on the queue until woken;
+					// interrupts must be off
+};
+
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
 //
@@ -36,8 +60,11 @@
 // into a register, a context switch might have occurred,
 // and some other thread might have called P or V, so the true value might
 // now be different.
+//
+// A semaphore that starts at 1 is taken to be a mutex: the thread
+// whose P takes it to 0 holds it, until the next V.
 
-class Semaphore {
+class Semaphore : public HeldObject {
   public:
     Semaphore(char* debugName, int initialValue);	// set initial value
     ~Semaphore();   					// de-allocate semaphore
@@ -45,11 +72,17 @@ class Semaphore {
     
     void P();	 // these are the only operations on a semaphore
     void V();	 // they are both *atomic*
+
+    // For the semaphores of user programs (system_call_SemCtl)
+    int getValue() { return value; }
+    void setValue(int newValue);	// wakes up as many waiters as
+					// the new value lets through
+    bool hasWaiters() { return !queue->IsEmpty(); }
     
   private:
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
-    List *queue;       // threads waiting in P() for the value to be > 0
+    bool isMutex;      // started at 1; "holder" holds it while it is 0
 };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -63,8 +96,13 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// Release hands a BUSY lock straight to the thread that has waited
+// longest, so waiters get the lock in FIFO order, and a woken waiter
+// never has to check the lock again.  Each lock counts how often it
+// was acquired, how often that meant waiting, and for how long.
 
-class Lock {
+class Lock : public HeldObject {
   public:
     Lock(char* debugName);  		// initialize lock to be FREE
     ~Lock();				// deallocate lock
@@ -78,9 +116,16 @@ class Lock {
 					// checking in Release, and in
 					// Condition variable ops below.
 
+    int getAcquisitions() { return acquisitions; }
+    int getContended() { return contended; }
+    int getWaitTicks() { return waitTicks; }
+
   private:
     char* name;				// for debugging
-    // plus some other stuff you'll need to define
+					// "holder" is the owner, NULL if FREE
+    int acquisitions;			// times the lock was acquired,
+    int contended;			// of which the lock was BUSY,
+    int waitTicks;			// and the ticks spent waiting
 };
 
 // The following class defines a "condition variable".  A condition
@@ -132,6 +177,6 @@ class Condition {
 
   private:
     char* name;
-    // plus some other stuff you'll need to define
+    List *queue;			// threads waiting in Wait, in order
 };
 #endif // SYNCH_H
@@ -11,49 +11,68 @@
 // This defines *all* of the global data structures used by Nachos.
 // These are all initialized and de-allocated by this file.
 
-NachOSThread *currentThread;			// the thread we are running now
-NachOSThread *threadToBeDestroyed;  		// the thread that just finished
-NachOSscheduler *scheduler;			// the ready list
-Interrupt *interrupt;			// interrupt status
-Statistics *stats;			// performance metrics
-Timer *timer;				// the hardware timer device,
+SimulationLocal NachOSThread *currentThread;			// the thread we are running now
+SimulationLocal NachOSThread *threadToBeDestroyed;  		// the thread that just finished
+SimulationLocal NachOSscheduler *scheduler;			// the ready list
+SimulationLocal Interrupt *interrupt;			// interrupt status
+SimulationLocal Statistics *stats;			// performance metrics
+SimulationLocal Timer *timer;				// the hardware timer device,
 					// for invoking context switches
-
-unsigned numPagesAllocated; // Only useful for NO_REPL
-unsigned usedPages; // Simply counts the currently used up pages
-
-NachOSThread *threadArray[MAX_THREAD_COUNT];  // Array of thread pointers
-unsigned thread_index;			// Index into this array (also used to assign unique pid)
-bool initializedConsoleSemaphores;
-bool exitThreadArray[MAX_THREAD_COUNT];  //Marks exited threads
-
-TimeSortedWaitQueue *sleepQueueHead;	// Needed to implement system_call_Sleep
-
-int schedulingAlgo;			// Scheduling algorithm to simulate
-char **batchProcesses;			// Names of batch processes
-int *priority;				// Process priority
-int replacementAlgo;        // Page replacement algo used with -R flag
-int LRU_Clock_ptr;          // LRU Clock Hand
-List *FIFOQueue;            // Queue used by Page replacement algorithm
-
-int cpu_burst_start_time;        // Records the start of current CPU burst
-int completionTimeArray[MAX_THREAD_COUNT];        // Records the completion time of all simulated threads
-bool excludeMainThread;		// Used by completion time statistics calculation
+SimulationLocal InputLog *inputLog;			// inputs being recorded or
+					// replayed, NULL if neither
+
+SimulationLocal unsigned numPagesAllocated; // Only useful for NO_REPL
+SimulationLocal unsigned usedPages; // Simply counts the currently used up pages
+
+SimulationLocal NachOSThread *threadArray[MAX_THREAD_COUNT];  // Array of thread pointers
+SimulationLocal unsigned thread_index;			// Index into this array (also used to assign unique pid)
+SimulationLocal bool exitThreadArray[MAX_THREAD_COUNT];  //Marks exited threads
+
+SimulationLocal TimeSortedWaitQueue *sleepQueueHead;	// Needed to implement system_call_Sleep
+
+SimulationLocal int schedulingAlgo;			// Scheduling algorithm to simulate
+SimulationLocal char **batchProcesses;			// Names of batch processes
+SimulationLocal int *priority;				// Process priority
+SimulationLocal int replacementAlgo;        // Page replacement algo used with -R flag
+SimulationLocal int pageTableType;          // Page table organization used with -T flag
+SimulationLocal bool useLargePages;         // Map code and data with large pages (-lp)
+SimulationLocal int LRU_Clock_ptr;          // LRU Clock Hand
+SimulationLocal List *FIFOQueue;            // Queue used by Page replacement algorithm
+SimulationLocal char *checkpointName;       // Checkpoint file (-ckpt)
+SimulationLocal int checkpointTick;         // Earliest tick of the checkpoint
+SimulationLocal char *branchPolicies;       // Policies to branch into (-branch)
+SimulationLocal int branchTick;             // Earliest tick of the branch
+SimulationLocal int branchSyscall;          // ... or system call, if not 0
+
+SimulationLocal int cpu_burst_start_time;        // Records the start of current CPU burst
+SimulationLocal int numCPUs;			// CPUs simulated, set with -cpus
+SimulationLocal int currentCPU;			// CPU whose turn it is
+SimulationLocal int completionTimeArray[MAX_THREAD_COUNT];        // Records the completion time of all simulated threads
+SimulationLocal bool excludeMainThread;		// Used by completion time statistics calculation
+SimulationLocal VoidNoArgFunctionPtr endSimulation;	// Set by the sweep driver
 
 #ifdef FILESYS_NEEDED
-FileSystem  *fileSystem;
+SimulationLocal FileSystem  *fileSystem;
 #endif
 
 #ifdef FILESYS
-SynchDisk   *synchDisk;
+SimulationLocal SynchDisk   *synchDisk;
 #endif
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
-Machine *machine;	// user program memory and registers
+SimulationLocal Machine *machine;	// user program memory and registers
+SimulationLocal UserSynchTable *userSemaphores;
+SimulationLocal UserSynchTable *userConditions;
+SimulationLocal FutexTable *futexTable;
+SimulationLocal ConsoleDriver *consoleDriver;
+#endif
+
+#ifdef USE_TLB
+SimulationLocal TLBManager *tlbManager;	// refills the machine's TLB
 #endif
 
 #ifdef NETWORK
-PostOffice *postOffice;
+SimulationLocal PostOffice *postOffice;
 #endif
 
 
@@ -116,8 +135,16 @@ Initialize(int argc, char **argv)
     int argCount, i;
     char* debugArgs = "";
     bool randomYield = FALSE;
+    char *logName = NULL;	// -record or -replay log
+    bool recordLog = FALSE;
 
-    initializedConsoleSemaphores = false;
+    useLargePages = FALSE;
+#ifdef USER_PROGRAM
+    SetPageSize(DefaultPageSize);		// unless -ps
+#endif
+    RandomInit(1);				// the default stream, unless -rs
+    numCPUs = 1;
+    currentCPU = 0;
     numPagesAllocated = 0;
     usedPages = 0;
 
@@ -140,9 +167,24 @@ Initialize(int argc, char **argv)
 
     sleepQueueHead = NULL;
     FIFOQueue = new List;
+    checkpointName = NULL;
+    checkpointTick = 0;
+    branchPolicies = NULL;
+    branchTick = branchSyscall = 0;
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    char *consoleIn = NULL, *consoleOut = NULL;	// -c files, else the terminal
+    int cacheArgs[NumCaches][4];	// size, line size, ways, miss penalty
+    bool useCache[NumCaches] = { FALSE, FALSE };
+    int predictor = -1;		// branch predictor, -1 without -pipe
+    int predictorSize = DefaultPredictorSize;
+    int mispredictPenalty = DefaultMispredictPenalty;
+#endif
+#ifdef USE_TLB
+    int tlbEntries = TLBSize, tlbAssoc = TLBWays;	// TLB geometry
+    bool tlbWaysGiven = FALSE;	// -tlbways; else fully associative
+    int tlbPolicy = TLB_LRU_REPL;	// TLB replacement policy
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
@@ -167,10 +209,88 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-cpus")) {
+	    ASSERT(argc > 1);
+	    numCPUs = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-record") || !strcmp(*argv, "-replay")) {
+	    ASSERT(argc > 1);
+	    recordLog = !strcmp(*argv, "-record");
+	    logName = *(argv + 1);
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-c")) {	// ConsoleTest's files, for
+	    if (argc > 1) {			// the one console driver
+		ASSERT(argc > 2);
+		consoleIn = *(argv + 1);
+		consoleOut = *(argv + 2);
+		argCount = 3;
+	    }
+	} else if (!strcmp(*argv, "-ps")) {
+	    ASSERT(argc > 1);
+	    SetPageSize(atoi(*(argv + 1)));	// must precede new Machine
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-lp"))
+	    useLargePages = TRUE;
+	else if (!strcmp(*argv, "-ckpt")) {
+	    ASSERT(argc > 2);
+	    checkpointTick = atoi(*(argv + 1));
+	    checkpointName = *(argv + 2);
+	    argCount = 3;
+	} else if (!strcmp(*argv, "-branch")) {
+	    ASSERT(argc > 2);
+	    if (endSimulation != NULL) {	// a -sweep job: a forked child
+						// would keep only this host
+						// thread
+	        printf("-branch is not supported under -sweep, ignored\n");
+	    } else {
+	        if (**(argv + 1) == '@')	// the n-th system call
+	            branchSyscall = atoi(*(argv + 1) + 1);
+	        else
+	            branchTick = atoi(*(argv + 1));
+	        branchPolicies = *(argv + 2);
+	    }
+	    argCount = 3;
+	}
+	else if (!strcmp(*argv, "-icache") || !strcmp(*argv, "-dcache")) {
+	    int which = strcmp(*argv, "-icache") ? DCACHE : ICACHE;
+	    ASSERT(argc > 4);
+	    for (i = 0; i < 4; i++)
+	        cacheArgs[which][i] = atoi(*(argv + 1 + i));
+	    useCache[which] = TRUE;
+	    argCount = 5;
+	} else if (!strcmp(*argv, "-pipe")) {
+	    ASSERT(argc > 1);
+	    predictor = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-bpsize")) {
+	    ASSERT(argc > 1);
+	    predictorSize = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-bppenalty")) {
+	    ASSERT(argc > 1);
+	    mispredictPenalty = atoi(*(argv + 1));
+	    argCount = 2;
+	}
+#endif
+#ifdef USE_TLB
+	if (!strcmp(*argv, "-tlb")) {
+	    ASSERT(argc > 1);
+	    tlbEntries = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tlbways")) {
+	    ASSERT(argc > 1);
+	    tlbAssoc = atoi(*(argv + 1));
+	    tlbWaysGiven = TRUE;
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tlbrepl")) {
+	    ASSERT(argc > 1);
+	    tlbPolicy = atoi(*(argv + 1));
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
@@ -191,6 +311,9 @@ Initialize(int argc, char **argv)
 
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
+    inputLog = NULL;
+    if (logName != NULL)			// before anything draws a
+	inputLog = new InputLog(logName, recordLog);	// random number
     interrupt = new Interrupt;			// start up interrupt handling
     scheduler = new NachOSscheduler();		// initialize the ready queue
     //if (randomYield)				// start the timer (if needed)
@@ -204,16 +327,40 @@ Initialize(int argc, char **argv)
     currentThread = NULL;
     currentThread = new NachOSThread("main", MIN_NICE_PRIORITY);
     currentThread->setStatus(RUNNING);
+    scheduler->SetRunningThread(currentThread);
     stats->start_time = stats->totalTicks;
     cpu_burst_start_time = stats->totalTicks;
     LRU_Clock_ptr = 0;
     replacementAlgo = 0;
+    pageTableType = FLAT_PAGE_TABLE;
 
     interrupt->Enable();
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
 
 #ifdef USER_PROGRAM
+#ifdef USE_TLB
+    if (!tlbWaysGiven)
+        tlbAssoc = tlbEntries;		// still fully associative
+    SetTLBGeometry(tlbEntries, tlbAssoc);
+#endif
     machine = new Machine(debugUserProg);	// this must come first
+    stats->pageSize = PageSize;
+    if (useCache[ICACHE])
+        machine->icache = new Cache("I-cache", cacheArgs[ICACHE][0],
+		cacheArgs[ICACHE][1], cacheArgs[ICACHE][2], cacheArgs[ICACHE][3]);
+    if (useCache[DCACHE])
+        machine->dcache = new Cache("D-cache", cacheArgs[DCACHE][0],
+		cacheArgs[DCACHE][1], cacheArgs[DCACHE][2], cacheArgs[DCACHE][3]);
+    if (predictor != -1)
+        machine->pipeline = new PipelineModel(predictor, predictorSize,
+					      mispredictPenalty);
+    userSemaphores = new UserSynchTable();
+    userConditions = new UserSynchTable();
+    futexTable = new FutexTable();
+    consoleDriver = new ConsoleDriver(consoleIn, consoleOut);
+#endif
+#ifdef USE_TLB
+    tlbManager = new TLBManager(tlbPolicy);
 #endif
 
 #ifdef FILESYS
@@ -243,6 +390,10 @@ Cleanup()
 
 #ifdef USER_PROGRAM
     delete machine;
+    delete userSemaphores;
+    delete userConditions;
+    delete futexTable;
+    delete consoleDriver;
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -256,7 +407,10 @@ Cleanup()
     delete timer;
     delete scheduler;
     delete interrupt;
+    delete inputLog;				// finishes a recording
 
+    if (endSimulation != NULL)
+	(*endSimulation)();			// does not return
     Exit(0);
 }
 
@@ -15,6 +15,7 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "replay.h"
 // #include "lish.h"
 
 #define MAX_THREAD_COUNT 1000
@@ -33,6 +34,10 @@
 #define LRU_REPL 3
 #define LRU_CLOCK_REPL 4
 
+// Page table organizations
+#define FLAT_PAGE_TABLE 0
+#define TWO_LEVEL_PAGE_TABLE 1
+
 #define SCHED_QUANTUM		100		// If not a multiple of timer interval, quantum will overshoot
 
 #define INITIAL_TAU		SystemTick	// Initial guess of the burst is set to the overhead of system activity
@@ -48,33 +53,50 @@ extern void Initialize(int argc, char **argv); 	// Initialization,
 						// called before anything else
 extern void Cleanup();				// Cleanup, called when
 						// Nachos is done.
-
-extern NachOSThread *currentThread;			// the thread holding the CPU
-extern NachOSThread *threadToBeDestroyed;  		// the thread that just finished
-extern NachOSscheduler *scheduler;			// the ready list
-extern Interrupt *interrupt;			// interrupt status
-extern Statistics *stats;			// performance metrics
-extern Timer *timer;				// the hardware alarm clock
-extern unsigned numPagesAllocated; // Only useful for NO_REPL
-extern unsigned usedPages; // Simply counts the currently used up pages
-
-
-extern NachOSThread *threadArray[];  // Array of thread pointers
-extern unsigned thread_index;                  // Index into this array (also used to assign unique pid)
-extern bool initializedConsoleSemaphores;	// Used to initialize the semaphores for console I/O exactly once
-extern bool exitThreadArray[];		// Marks exited threads
-
-extern int schedulingAlgo;		// Scheduling algorithm to simulate
-extern char **batchProcesses;		// Names of batch executables
-extern int *priority;			// Process priority
-extern int replacementAlgo;        // Page replacement algo used with -R flag
-
-extern int cpu_burst_start_time;	// Records the start of current CPU burst
-extern int completionTimeArray[];	// Records the completion time of all simulated threads
-extern bool excludeMainThread;		// Used by completion time statistics calculation
-
-extern int LRU_Clock_ptr;               // Used by LRU_CLOCK Page replacement algorithm
-extern List *FIFOQueue;                 // Queue used by FIFO page replacement algorithm
+extern SimulationLocal VoidNoArgFunctionPtr endSimulation;
+						// If set, called by Cleanup
+						// instead of exiting (sweep.cc)
+
+extern SimulationLocal NachOSThread *currentThread;			// the thread holding the CPU
+extern SimulationLocal NachOSThread *threadToBeDestroyed;  		// the thread that just finished
+extern SimulationLocal NachOSscheduler *scheduler;			// the ready list
+extern SimulationLocal Interrupt *interrupt;			// interrupt status
+extern SimulationLocal Statistics *stats;			// performance metrics
+extern SimulationLocal Timer *timer;				// the hardware alarm clock
+extern SimulationLocal InputLog *inputLog;		// -record or -replay log, or NULL
+extern SimulationLocal unsigned numPagesAllocated; // Only useful for NO_REPL
+extern SimulationLocal unsigned usedPages; // Simply counts the currently used up pages
+
+
+extern SimulationLocal NachOSThread *threadArray[];  // Array of thread pointers
+extern SimulationLocal unsigned thread_index;                  // Index into this array (also used to assign unique pid)
+extern SimulationLocal bool exitThreadArray[];		// Marks exited threads
+
+extern SimulationLocal int schedulingAlgo;		// Scheduling algorithm to simulate
+extern SimulationLocal char **batchProcesses;		// Names of batch executables
+extern SimulationLocal int *priority;			// Process priority
+extern SimulationLocal int replacementAlgo;        // Page replacement algo used with -R flag
+extern SimulationLocal int pageTableType;          // Page table organization used with -T flag
+extern SimulationLocal bool useLargePages;         // Map code and data with large pages (-lp)
+
+extern SimulationLocal int cpu_burst_start_time;	// Records the start of current CPU burst
+					// (on the current CPU)
+extern SimulationLocal int numCPUs;			// CPUs simulated, set with -cpus
+extern SimulationLocal int currentCPU;			// CPU whose turn it is
+extern SimulationLocal int completionTimeArray[];	// Records the completion time of all simulated threads
+extern SimulationLocal bool excludeMainThread;		// Used by completion time statistics calculation
+
+extern SimulationLocal int LRU_Clock_ptr;               // Used by LRU_CLOCK Page replacement algorithm
+extern SimulationLocal List *FIFOQueue;                 // Queue used by FIFO page replacement algorithm
+
+extern SimulationLocal char *checkpointName;		// Checkpoint file, set with -ckpt,
+							// NULL once it is written
+extern SimulationLocal int checkpointTick;		// ... taken at the first safe
+							// system call from this tick on
+extern SimulationLocal char *branchPolicies;		// Policies to branch into, set
+							// with -branch; NULL once done
+extern SimulationLocal int branchTick;			// ... from this tick on, or
+extern SimulationLocal int branchSyscall;		// ... from this system call on
 
 class TimeSortedWaitQueue {		// Needed to implement system_call_Sleep
 private:
@@ -92,26 +114,39 @@ public:
    void SetNext (TimeSortedWaitQueue *n) { next = n; }
 };
 
-extern TimeSortedWaitQueue *sleepQueueHead;
+extern SimulationLocal TimeSortedWaitQueue *sleepQueueHead;
 
 #ifdef USER_PROGRAM
 #include "machine.h"
-extern Machine* machine;	// user program memory and registers
+#include "usersynch.h"
+#include "futex.h"
+#include "consoledriver.h"
+extern SimulationLocal Machine* machine;	// user program memory and registers
+extern SimulationLocal UserSynchTable *userSemaphores;	// SemGet/SemOp/SemCtl
+extern SimulationLocal UserSynchTable *userConditions;	// CondGet/CondOp/CondRemove
+extern SimulationLocal FutexTable *futexTable;		// FutexWait/FutexWake
+extern SimulationLocal ConsoleDriver *consoleDriver;	// the console, for
+							// user programs
+#endif
+
+#ifdef USE_TLB
+#include "tlb.h"
+extern SimulationLocal TLBManager *tlbManager;	// refills the machine's TLB
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB
 #include "filesys.h"
-extern FileSystem  *fileSystem;
+extern SimulationLocal FileSystem  *fileSystem;
 #endif
 
 #ifdef FILESYS
 #include "synchdisk.h"
-extern SynchDisk   *synchDisk;
+extern SimulationLocal SynchDisk   *synchDisk;
 #endif
 
 #ifdef NETWORK
 #include "post.h"
-extern PostOffice* postOffice;
+extern SimulationLocal PostOffice* postOffice;
 #endif
 
 #endif // SYSTEM_H
@@ -42,7 +42,9 @@ NachOSThread::NachOSThread(char* threadName, int nice)
     status = JUST_CREATED;
 #ifdef USER_PROGRAM
     space = NULL;
+    userStack = -1;
     stateRestored = true;
+    resumable = true;
 #endif
 
     threadArray[thread_index] = this;
@@ -62,6 +64,9 @@ NachOSThread::NachOSThread(char* threadName, int nice)
     for (i=0; i<MAX_CHILD_COUNT; i++) exitedChild[i] = false;
 
     instructionCount = 0;
+    pageFaultCount = 0;
+    cpu = -1;
+    for (i=0; i<NumCaches; i++) { cacheHitCount[i] = 0; cacheMissCount[i] = 0; }
 
     if (nice == GET_NICE_FROM_PARENT) {
        if (ppid != -1) {
@@ -76,6 +81,7 @@ NachOSThread::NachOSThread(char* threadName, int nice)
     }
     schedPriority = basePriority;
     usage = 0;
+    heldObjects = NULL;
 
     if (schedulingAlgo == NON_PREEMPTIVE_SJF) schedPriority = INITIAL_TAU;
 }
@@ -97,6 +103,10 @@ NachOSThread::~NachOSThread()
     DEBUG('t', "Deleting thread \"%s\"\n", name);
 
     ASSERT(this != currentThread);
+    while (heldObjects != NULL) {	// a mutex semaphore it never V'd
+	heldObjects->holder = NULL;
+	heldObjects = heldObjects->nextHeld;
+    }
     if (stack != NULL)
 	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
 
@@ -263,6 +273,14 @@ NachOSThread::Exit (bool terminateSim, int exitcode)
     status = BLOCKED;
     completionTimeArray[currentThread->GetPID()] = stats->totalTicks;
 
+#ifdef USER_PROGRAM
+    if ((machine->icache != NULL) || (machine->dcache != NULL)) {
+       printf("[pid %d]: I-cache hits %u, misses %u; D-cache hits %u, misses %u\n",
+              pid, cacheHitCount[ICACHE], cacheMissCount[ICACHE],
+              cacheHitCount[DCACHE], cacheMissCount[DCACHE]);
+    }
+#endif
+
     // Set exit code in parent's structure provided the parent hasn't exited
     if (ppid != -1) {
        if (!exitThreadArray[ppid]) {
@@ -272,6 +290,10 @@ NachOSThread::Exit (bool terminateSim, int exitcode)
     }
 
     nextThread = scheduler->FindNextThreadToRun();
+    if (nextThread == NULL) {
+       nextThread = scheduler->ResumeOtherCPU();	// -cpus: another CPU
+							// may still be busy
+    }
     if (nextThread == NULL) {
        scheduler->SetEmptyReadyQueueStartTime(stats->totalTicks);
     }
@@ -286,17 +308,20 @@ NachOSThread::Exit (bool terminateSim, int exitcode)
        nextThread = scheduler->FindNextThreadToRun();
     }
 
-    TranslationEntry *NachOSpageTable = space->GetPageTable();
-    unsigned numPagesInVM = space->GetNumPages();
-
-    int physPageNumber;
-    for(int i = 0; i < numPagesInVM; i++) {
-        if (!NachOSpageTable[i].shared && NachOSpageTable[i].valid) {
-            physPageNumber = NachOSpageTable[i].physicalPage;
-            machine->memoryUsedBy[physPageNumber] = -1;
-            machine->virtualPageNo[physPageNumber] = -1;
-            usedPages--;
-        }
+    if (space->NumThreads() == 0) {
+       space->ReleasePhysicalPages();	// the last thread of the space
+       if (space->pid != pid) {
+          // The thread the space was made with was kept for its frames
+          ASSERT(exitThreadArray[space->pid]);
+          delete threadArray[space->pid];
+          threadArray[space->pid] = NULL;
+       }
+    }
+    else if (space->pid == pid) {
+       // The frames of a shared space are found through the pid it was
+       // made with, so the thread with that pid is kept while other
+       // threads still run in the space
+       threadToBeDestroyed = NULL;
     }
 
     scheduler->Schedule(nextThread); // returns when we've been signalled
@@ -410,6 +435,10 @@ NachOSThread::PutThreadToSleep ()
     }
     status = BLOCKED;
     nextThread = scheduler->FindNextThreadToRun();
+    if (nextThread == NULL) {
+       nextThread = scheduler->ResumeOtherCPU();	// -cpus: another CPU
+							// may still be busy
+    }
     if (nextThread == NULL) {
        scheduler->SetEmptyReadyQueueStartTime (stats->totalTicks);
     }
@@ -515,8 +544,101 @@ NachOSThread::RestoreUserState()
 {
     for (int i = 0; i < NumTotalRegs; i++)
 	machine->WriteRegister(i, userRegisters[i]);
+    machine->BreakLink();		// another thread may have run
     stateRestored = true;
 }
+
+#include "checkpoint.h"
+
+//----------------------------------------------------------------------
+// NachOSThread::Checkpoint
+//	Write the thread's family, scheduling state, counters, user
+//	registers and address space to a checkpoint.  The thread must
+//	be resumable.
+//
+//	The running thread is checkpointed on entry to a system call,
+//	before the handler has done anything.  Its registers are still
+//	in the machine, and the restored thread issues the system call
+//	again, so the syscall instruction is taken back out of its
+//	instruction count.
+//----------------------------------------------------------------------
+
+void
+NachOSThread::Checkpoint(CheckpointFile *file)
+{
+    int i;
+
+    file->WriteInt(ppid);
+    file->WriteInt(childcount);
+    file->Write(childpidArray, childcount * sizeof(int));
+    file->Write(childexitcode, childcount * sizeof(int));
+    file->Write(exitedChild, childcount * sizeof(bool));
+    file->WriteInt(waitchild_id);
+
+    file->WriteInt(status);
+    file->WriteInt(wait_start_time);
+    file->WriteInt(burst_start_time);
+    file->WriteInt(cpu);
+    file->WriteInt(basePriority);
+    file->WriteInt(schedPriority);
+    file->WriteInt(usage);
+
+    if (this == currentThread) {
+	file->WriteInt(instructionCount - 1);
+	for (i = 0; i < NumTotalRegs; i++)
+	    file->WriteInt(machine->ReadRegister(i));
+    } else {
+	ASSERT(!stateRestored);
+	file->WriteInt(instructionCount);
+	file->Write(userRegisters, sizeof(userRegisters));
+    }
+    file->WriteInt(pageFaultCount);
+    file->Write(cacheHitCount, sizeof(cacheHitCount));
+    file->Write(cacheMissCount, sizeof(cacheMissCount));
+
+    space->Checkpoint(file);
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::Restore
+//	Read back what NachOSThread::Checkpoint wrote, into a thread
+//	that has just been created with the saved pid.  The thread gets
+//	a fresh stack that starts it at its user registers, but it is
+//	not put on any queue; the caller does that.
+//
+//	"startFunc" is the kernel procedure that starts the user program
+//----------------------------------------------------------------------
+
+void
+NachOSThread::Restore(CheckpointFile *file, VoidFunctionPtr startFunc)
+{
+    ppid = file->ReadInt();
+    childcount = file->ReadInt();
+    ASSERT(childcount < MAX_CHILD_COUNT);
+    file->Read(childpidArray, childcount * sizeof(int));
+    file->Read(childexitcode, childcount * sizeof(int));
+    file->Read(exitedChild, childcount * sizeof(bool));
+    waitchild_id = file->ReadInt();
+
+    status = (ThreadStatus) file->ReadInt();
+    wait_start_time = file->ReadInt();
+    burst_start_time = file->ReadInt();
+    cpu = file->ReadInt();
+    basePriority = file->ReadInt();
+    schedPriority = file->ReadInt();
+    usage = file->ReadInt();
+
+    instructionCount = file->ReadInt();
+    file->Read(userRegisters, sizeof(userRegisters));
+    stateRestored = false;
+    resumable = true;
+    pageFaultCount = file->ReadInt();
+    file->Read(cacheHitCount, sizeof(cacheHitCount));
+    file->Read(cacheMissCount, sizeof(cacheMissCount));
+
+    space = new ProcessAddrSpace(file, pid);
+    AllocateThreadStack(startFunc, 0);
+}
 #endif
 
 //----------------------------------------------------------------------
@@ -670,6 +792,62 @@ NachOSThread::GetInstructionCount (void)
    return instructionCount;
 }
 
+//----------------------------------------------------------------------
+// NachOSThread::IncPageFaultCount
+//      Called by ProcessAddrSpace::PageFaultHandler
+//----------------------------------------------------------------------
+
+void
+NachOSThread::IncPageFaultCount (void)
+{
+   pageFaultCount++;
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::GetPageFaultCount
+//      Called by SYScall_NumPageFaults
+//----------------------------------------------------------------------
+
+unsigned
+NachOSThread::GetPageFaultCount (void)
+{
+   return pageFaultCount;
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::IncCacheHitCount, NachOSThread::IncCacheMissCount
+//      Called by Machine::CacheReference; "which" is ICACHE or DCACHE
+//----------------------------------------------------------------------
+
+void
+NachOSThread::IncCacheHitCount (int which)
+{
+   cacheHitCount[which]++;
+}
+
+void
+NachOSThread::IncCacheMissCount (int which)
+{
+   cacheMissCount[which]++;
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::GetCacheHitCount, NachOSThread::GetCacheMissCount
+//      Reported when the thread exits
+//----------------------------------------------------------------------
+
+unsigned
+NachOSThread::GetCacheHitCount (int which)
+{
+   return cacheHitCount[which];
+}
+
+unsigned
+NachOSThread::GetCacheMissCount (int which)
+{
+   return cacheMissCount[which];
+}
+
 void
 NachOSThread::SetWaitStartTime (int ticks)
 {
@@ -720,6 +898,27 @@ NachOSThread::GetPriority (void)
    return schedPriority;
 }
 
+//----------------------------------------------------------------------
+// NachOSThread::GetEffectivePriority
+//	The priority the scheduler runs the thread at: its own, or the
+//	best effective priority of the threads waiting for an object it
+//	holds, if that is better (lower).  Since a waiter's effective
+//	priority counts its own waiters, inheritance runs down chains of
+//	holders.  A thread waits for one object at a time, so there can
+//	be no cycle below a thread that is not waiting itself.
+//----------------------------------------------------------------------
+
+int
+NachOSThread::GetEffectivePriority (void)
+{
+   int best = schedPriority;
+   HeldObject *object;
+
+   for (object = heldObjects; object != NULL; object = object->nextHeld)
+      best = object->queue->GetMinEffectivePriority(best);
+   return best;
+}
+
 void 
 NachOSThread::SetUsage (int u)
 {
@@ -41,10 +41,13 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "cache.h"
 
 #ifdef USER_PROGRAM
 #include "machine.h"
 #include "addrspace.h"
+
+class CheckpointFile;
 #endif
 
 // CPU register state to be saved on context switch.  
@@ -64,6 +67,8 @@ enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED };
 // external function, dummy routine whose sole job is to call NachOSThread::Print
 extern void ThreadPrint(int arg);	 
 
+class HeldObject;			// a Lock or mutex Semaphore, see synch.h
+
 // The following class defines a "thread control block" -- which
 // represents a single thread of execution.
 //
@@ -137,6 +142,14 @@ class NachOSThread {
     void IncInstructionCount();
     unsigned GetInstructionCount();
 
+    void IncPageFaultCount();
+    unsigned GetPageFaultCount();
+
+    void IncCacheHitCount(int which);		// which is ICACHE or DCACHE
+    void IncCacheMissCount(int which);
+    unsigned GetCacheHitCount(int which);
+    unsigned GetCacheMissCount(int which);
+
     void SetWaitStartTime (int ticks);
     int GetWaitStartTime (void);
 
@@ -148,10 +161,18 @@ class NachOSThread {
 
     void SetPriority (int p);
     int GetPriority (void);
+    int GetEffectivePriority (void);	// GetPriority, or a better one
+					// inherited from waiters on
+					// heldObjects
+
+    HeldObject *heldObjects;		// Locks and mutex semaphores I hold
 
     void SetUsage (int usage);
     int GetUsage (void);
 
+    void SetCPU (int c) { cpu = c; }
+    int GetCPU (void) { return cpu; }
+
   private:
     // some of the private data for this class is listed above
     
@@ -174,10 +195,15 @@ class NachOSThread {
     int wait_start_time;		// Start tick of wait in ready queue
     int burst_start_time;		// Start of the current CPU burst
 
+    int cpu;				// CPU I last ran on, -1 if none yet
+
     int basePriority, schedPriority, usage;	// Used by the UNIX scheduler
 						// schedPriority is also used to store the next burst estimate
 
     unsigned instructionCount;          // Keeps track of the instruction count executed by this thread
+    unsigned pageFaultCount;            // Page faults taken by this thread
+    unsigned cacheHitCount[NumCaches];          // Cache hits and misses of this
+    unsigned cacheMissCount[NumCaches];         // thread, per cache
 
 #ifdef USER_PROGRAM
 // A thread running a user program actually has *two* sets of CPU registers -- 
@@ -186,12 +212,27 @@ class NachOSThread {
 
     int userRegisters[NumTotalRegs];	// user-level CPU register state
     bool stateRestored;
+    bool resumable;			// Would restarting the thread from
+					// its user registers carry on where
+					// it is?  FALSE while it is in the
+					// middle of kernel work
 
   public:
     void SaveUserState();		// save user-level register state
     void RestoreUserState();		// restore user-level register state
 
+    void SetResumable(bool r) { resumable = r; }
+    bool IsResumable() { return resumable; }
+
+    void Checkpoint(CheckpointFile *file);	// Save everything but the
+						// pid and the name
+    void Restore(CheckpointFile *file, VoidFunctionPtr startFunc);
+						// ... and read it back into
+						// a new thread
+
     ProcessAddrSpace *space;			// User code this thread is running.
+    int userStack;				// Top of the stack ThreadCreate
+						// gave this thread, or -1
 #endif
 };
 
@@ -21,7 +21,7 @@
 #endif
 #endif
 
-static char *enableFlags = NULL; // controls which DEBUG messages are printed 
+static SimulationLocal char *enableFlags = NULL; // controls which DEBUG messages are printed 
 
 //----------------------------------------------------------------------
 // DebugInit
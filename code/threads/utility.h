@@ -59,6 +59,14 @@
 typedef void (*VoidFunctionPtr)(int arg); 
 typedef void (*VoidNoArgFunctionPtr)(); 
 
+// Every piece of kernel and machine state is declared SimulationLocal:
+// each host thread gets its own copy, so that the sweep driver (see
+// sweep.cc) can run independent simulations on several host threads
+// of one process.  A host thread runs one simulation at a time, and
+// Initialize resets all of this state before each one.
+
+#define SimulationLocal __thread
+
 
 // Include interface that isolates us from the host machine system library.
 // Requires definition of bool, and VoidFunctionPtr
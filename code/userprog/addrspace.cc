@@ -19,6 +19,10 @@
 #include "system.h"
 #include "addrspace.h"
 #include "utility.h"
+#include "syscall.h"
+#include "checkpoint.h"
+#include "filetable.h"
+#include "usermem.h"
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -65,6 +69,7 @@ ProcessAddrSpace::ProcessAddrSpace(OpenFile *execfile, char *programname, int _p
     unsigned int pageFrame;
 
     pid = _pid;
+    files = new FileTable();
 
     fileName = copyFileName(programname);
 
@@ -74,32 +79,32 @@ ProcessAddrSpace::ProcessAddrSpace(OpenFile *execfile, char *programname, int _p
     	SwapHeader(&noffH);
     ASSERT(noffH.noffMagic == NOFFMAGIC);
 
-    // how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size
-        + UserStackSize;	// we need to increase the size
-    // to leave room for the stack
+    // how big is address space?  The stack is kept in its own page
+    // table below UserStackTop, so only code and data are counted here
+    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size;
     numPagesInVM = divRoundUp(size, PageSize);
     size = numPagesInVM * PageSize;
     swapMemory = new char[size];
 
+    // The heap starts out empty, just past the uninitialized data
+    heapBreak = size;
+    heapSize = 0;
+    numThreads = 1;
+    numFreeUserStacks = numGuardPages = 0;
+
+    // Only a small part of the stack is mapped up front; GrowStack
+    // adds pages as the program touches them
+    numStackPages = divRoundUp(UserStackInitialSize, PageSize);
+    stackSwapMemory = new char[numStackPages * PageSize];
+
     DEBUG('a', "Initializing address space, num pages %d, size %d\n",
           numPagesInVM, size);
     // first, set up the translation
-    NachOSpageTable = new TranslationEntry[numPagesInVM];
-    for (i = 0; i < numPagesInVM; i++) {
-        NachOSpageTable[i].virtualPage = i;
-        NachOSpageTable[i].physicalPage = -1;
-        NachOSpageTable[i].valid = FALSE;
-        NachOSpageTable[i].use = FALSE;
-        NachOSpageTable[i].dirty = FALSE;
-        NachOSpageTable[i].shared = FALSE;
-        NachOSpageTable[i].ifUsed = FALSE;
-
-        // if the code segment was entirely on
-        // a separate page, we could set its
-        // pages to be read-only
-        NachOSpageTable[i].readOnly = FALSE;
+    AllocatePageTables(pageTableType == TWO_LEVEL_PAGE_TABLE);
+    for (i = 0; i < NumEntries(); i++) {
+        InitEntry(NewEntry(VpnAt(i)), VpnAt(i));
     }
+    NotePageTableSize();
 }
 
 //----------------------------------------------------------------------
@@ -110,66 +115,176 @@ ProcessAddrSpace::ProcessAddrSpace(OpenFile *execfile, char *programname, int _p
 ProcessAddrSpace::ProcessAddrSpace(ProcessAddrSpace *parentSpace, int _pid)
 {
     pid = _pid;
+    files = new FileTable(parentSpace->files);	// shares the open files
     // printf("Forking off %d from %d\n", pid, currentThread->GetPID());
 
+#ifdef USE_TLB
+    // The parent's dirty bits may only be in the TLB so far
+    tlbManager->WriteBack(parentSpace->pid, FALSE);
+#endif
+
     numPagesInVM = parentSpace->GetNumPages();
     noffH = parentSpace->noffH;
-    unsigned i, numSharedPages = 0;
+    heapBreak = parentSpace->heapBreak;
+    heapSize = parentSpace->heapSize;
+    numThreads = 1;
+    numFreeUserStacks = parentSpace->numFreeUserStacks;
+    for (int j = 0; j < numFreeUserStacks; j++) {
+        freeUserStacks[j] = parentSpace->freeUserStacks[j];
+    }
+    numGuardPages = parentSpace->numGuardPages;
+    for (int j = 0; j < numGuardPages; j++) {
+        guardPages[j] = parentSpace->guardPages[j];
+    }
+    unsigned i;
 
     fileName = copyFileName(parentSpace->fileName);
 
-    TranslationEntry* parentPageTable = parentSpace->GetPageTable();
-
-    for(i = 0; i < numPagesInVM; ++i) {
-        if (parentPageTable[i].shared) {
-            ++ numSharedPages;
-        }
-    }
-
-    unsigned int size = (numPagesInVM - numSharedPages) * PageSize;
+    // Swap is indexed by vpn, so it must cover the shared pages too
+    unsigned int size = numPagesInVM * PageSize;
     swapMemory = new char[size];
     bzero(swapMemory, size);
 
-    // first, set up the translation
-    NachOSpageTable = new TranslationEntry[numPagesInVM];
-    for (i = 0; i < numPagesInVM; i++) {
-        NachOSpageTable[i].virtualPage = i;
-        NachOSpageTable[i].shared = parentPageTable[i].shared;
-        NachOSpageTable[i].ifUsed = parentPageTable[i].ifUsed;
-        NachOSpageTable[i].valid = parentPageTable[i].valid;
-        NachOSpageTable[i].use = parentPageTable[i].use;
-        NachOSpageTable[i].dirty = parentPageTable[i].dirty;
-        NachOSpageTable[i].readOnly = parentPageTable[i].readOnly;
+    // The child's stack is as deep as the parent's
+    numStackPages = parentSpace->numStackPages;
+    stackSwapMemory = new char[numStackPages * PageSize];
+    bzero(stackSwapMemory, numStackPages * PageSize);
+
+    // first, set up the translation, organized like the parent's
+    AllocatePageTables(parentSpace->pageDirectory != NULL);
+    for (i = 0; i < NumEntries(); i++) {
+        TranslationEntry *entry = NewEntry(VpnAt(i));
+        TranslationEntry *parentEntry = parentSpace->EntryAt(i);
+
+        entry->virtualPage = parentEntry->virtualPage;
+        entry->shared = parentEntry->shared;
+        entry->ifUsed = parentEntry->ifUsed;
+        entry->valid = parentEntry->valid;
+        entry->use = parentEntry->use;
+        entry->dirty = parentEntry->dirty;
+        entry->readOnly = parentEntry->readOnly;
+        entry->advice = parentEntry->advice;
+        entry->locked = FALSE;          // locks are not inherited
+        entry->largePage = FALSE;       // nor are large pages
     }
+    NotePageTableSize();
     // Copying of data will be done later on
 }
 
+//----------------------------------------------------------------------
+// ProcessAddrSpace::ProcessAddrSpace (CheckpointFile*) rebuilds an
+//      address space saved by ProcessAddrSpace::Checkpoint.  The frames
+//      its entries point to are restored with the rest of the machine.
+//----------------------------------------------------------------------
+
+ProcessAddrSpace::ProcessAddrSpace(CheckpointFile *file, int _pid)
+{
+    unsigned i;
+    bool twoLevel;
+
+    pid = _pid;
+    files = new FileTable();		// only the console was open
+    fileName = file->ReadString();
+    file->Read(&noffH, sizeof(noffH));
+    numPagesInVM = file->ReadInt();
+    heapBreak = file->ReadInt();
+    heapSize = file->ReadInt();
+    numThreads = 1;
+    numFreeUserStacks = file->ReadInt();
+    file->Read(freeUserStacks, numFreeUserStacks * sizeof(int));
+    numGuardPages = file->ReadInt();
+    file->Read(guardPages, numGuardPages * sizeof(unsigned));
+    numStackPages = file->ReadInt();
+    twoLevel = file->ReadInt();
+
+    AllocatePageTables(twoLevel);
+    for (i = 0; i < NumEntries(); i++) {
+        file->Read(NewEntry(VpnAt(i)), sizeof(TranslationEntry));
+    }
+
+    swapMemory = new char[numPagesInVM * PageSize];
+    file->ReadMemory(swapMemory, numPagesInVM * PageSize);
+    stackSwapMemory = new char[numStackPages * PageSize];
+    file->ReadMemory(stackSwapMemory, numStackPages * PageSize);
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::Checkpoint
+//      Writes everything needed to rebuild this space: its layout
+//      (the ThreadCreate stacks and their guard pages included),
+//      every page table entry and the swap areas.  With a TLB, the
+//      caller writes the TLB's use and dirty bits back first.
+//----------------------------------------------------------------------
+
+void ProcessAddrSpace::Checkpoint(CheckpointFile *file) {
+    unsigned i;
+
+    file->WriteString(fileName);
+    file->Write(&noffH, sizeof(noffH));
+    file->WriteInt(numPagesInVM);
+    file->WriteInt(heapBreak);
+    file->WriteInt(heapSize);
+    file->WriteInt(numFreeUserStacks);
+    file->Write(freeUserStacks, numFreeUserStacks * sizeof(int));
+    file->WriteInt(numGuardPages);
+    file->Write(guardPages, numGuardPages * sizeof(unsigned));
+    file->WriteInt(numStackPages);
+    file->WriteInt(pageDirectory != NULL);
+
+    for (i = 0; i < NumEntries(); i++) {
+        file->Write(EntryAt(i), sizeof(TranslationEntry));
+    }
+
+    file->WriteMemory(swapMemory, numPagesInVM * PageSize);
+    file->WriteMemory(stackSwapMemory, numStackPages * PageSize);
+}
+
 // Copies all valid pages from the parent's space in case of forked process
 void ProcessAddrSpace::CopyParentAddrSpace(ProcessAddrSpace *parentSpace) {
     unsigned startAddrParent, startAddrChild, newPhysPage;
 
-    TranslationEntry* parentPageTable = parentSpace->GetPageTable();
+    TranslationEntry *entry, *parentEntry, *parentHead;
+
     memcpy(swapMemory, parentSpace->swapMemory, numPagesInVM*PageSize);
+    memcpy(stackSwapMemory, parentSpace->stackSwapMemory, numStackPages*PageSize);
+
+    for (unsigned i = 0; i < NumEntries(); i++) {
+        entry = EntryAt(i);
+        parentEntry = parentSpace->EntryAt(i);
+
+        parentHead = parentSpace->LargePageHead(entry->virtualPage);
+        if (parentHead != NULL) {
+            // The child gets a small page for each part of a large page
+            newPhysPage = GetNextPageToWrite(entry->virtualPage, -1);
+            entry->physicalPage = newPhysPage;
+            entry->valid = TRUE;
+            entry->ifUsed = TRUE;
+            entry->dirty = TRUE;
+
+            startAddrParent = (parentHead->physicalPage +
+                               entry->virtualPage % LargePageFactor)*PageSize;
+            startAddrChild = newPhysPage*PageSize;
+            memcpy(&(machine->mainMemory[startAddrChild]),
+                   &(machine->mainMemory[startAddrParent]), PageSize);
 
-    for (int i = 0; i < numPagesInVM; i++) {
-        NachOSpageTable[i].ifUsed = parentPageTable[i].ifUsed;
-        NachOSpageTable[i].valid = parentPageTable[i].valid;
+            stats->numPageFaults ++;
+            currentThread->SortedInsertInWaitQueue (1000+stats->totalTicks);
+            continue;
+        }
 
-        TranslationEntry* parentPageTable = parentSpace->GetPageTable();
-        // If shared memory, then physical page is from parent's address space
-        if (!parentPageTable[i].shared) {
+        entry->ifUsed = parentEntry->ifUsed;
+        entry->valid = parentEntry->valid;
 
-            // if (parentPageTable[i].ifUsed && !(parentPageTable[i].valid)) {
-            //     parentSpace->PageFaultHandler(i);
-            // }
+        // If shared memory, then physical page is from parent's address space
+        if (!parentEntry->shared) {
 
-            if (parentPageTable[i].valid) {
+            if (parentEntry->valid) {
                 // Get new page, but do not overwrite parent's page
-                newPhysPage = GetNextPageToWrite(i, parentPageTable[i].physicalPage);
+                newPhysPage = GetNextPageToWrite(entry->virtualPage, parentEntry->physicalPage);
 
-                NachOSpageTable[i].physicalPage = newPhysPage;
+                entry->physicalPage = newPhysPage;
 
-                startAddrParent = parentPageTable[i].physicalPage*PageSize;
+                startAddrParent = parentEntry->physicalPage*PageSize;
                 startAddrChild = newPhysPage*PageSize;
 
                 // Copy the contents
@@ -179,17 +294,119 @@ void ProcessAddrSpace::CopyParentAddrSpace(ProcessAddrSpace *parentSpace) {
                 stats->numPageFaults ++;
             }
         } else {
-            NachOSpageTable[i].physicalPage = parentPageTable[i].physicalPage;
+            entry->physicalPage = parentEntry->physicalPage;
             stats->numPageFaults ++;
         }
 
-        if (NachOSpageTable[i].valid && !(NachOSpageTable[i].shared)) {
+        if (entry->valid && !(entry->shared)) {
             currentThread->SortedInsertInWaitQueue (1000+stats->totalTicks);
         }
     }
     // printf("Parent is finished\n");
 }
 
+//----------------------------------------------------------------------
+// ProcessAddrSpace::AllocatePageTables
+//  Sets up empty page tables for numPagesInVM low pages and
+//  numStackPages stack pages: either the two flat arrays, or one
+//  two-level table that holds both parts.  NewEntry then hands out
+//  the entries.
+//----------------------------------------------------------------------
+
+void ProcessAddrSpace::AllocatePageTables(bool twoLevel) {
+    stackCapacity = numStackPages;
+    if (twoLevel) {
+        pageDirectory = new TwoLevelPageTable(UserStackTop/PageSize);
+        NachOSpageTable = NULL;
+        stackPageTable = NULL;
+    } else {
+        pageDirectory = NULL;
+        NachOSpageTable = new TranslationEntry[numPagesInVM];
+        stackPageTable = new TranslationEntry[numStackPages];
+    }
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::InitEntry
+//  Fills in a page that has never been used, so its first fault
+//  brings in a zeroed page (or the executable's copy)
+//----------------------------------------------------------------------
+
+void ProcessAddrSpace::InitEntry(TranslationEntry *entry, unsigned vpn) {
+    entry->virtualPage = vpn;
+    entry->physicalPage = -1;
+    entry->valid = FALSE;
+    entry->use = FALSE;
+    entry->dirty = FALSE;
+    entry->shared = FALSE;
+    entry->ifUsed = FALSE;
+    entry->advice = MADV_NORMAL;
+    entry->locked = FALSE;
+    entry->largePage = FALSE;
+
+    // if the code segment was entirely on
+    // a separate page, we could set its
+    // pages to be read-only
+    entry->readOnly = FALSE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::NotePageTableSize
+//  Records the host memory this space's page tables take, for the
+//  largest-page-table statistic
+//----------------------------------------------------------------------
+
+void ProcessAddrSpace::NotePageTableSize() {
+    int bytes;
+
+    if (pageDirectory != NULL) {
+        bytes = pageDirectory->GetTableBytes();
+    } else {
+        bytes = NumEntries() * sizeof(TranslationEntry);
+    }
+    if (bytes > stats->maxPageTableBytes) {
+        stats->maxPageTableBytes = bytes;
+    }
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::ExtendPageTable
+//  Appends numNewPages entries that have never been used to the low
+//  part of the address space (and grows the swap area to match).
+//  A flat page table has to be copied into a bigger array; a
+//  two-level one just maps the new pages.
+//----------------------------------------------------------------------
+
+void ProcessAddrSpace::ExtendPageTable(unsigned numNewPages) {
+    unsigned int i, newNumPages = numPagesInVM + numNewPages;
+    char *newSwapMemory = new char[newNumPages * PageSize];
+
+    memcpy(newSwapMemory, swapMemory, numPagesInVM * PageSize);
+    delete [] swapMemory;
+    swapMemory = newSwapMemory;
+
+    if (pageDirectory != NULL) {
+        for (i = numPagesInVM; i < newNumPages; ++ i) {
+            InitEntry(pageDirectory->Map(i), i);
+        }
+    } else {
+        TranslationEntry* NewTranslation = new TranslationEntry[newNumPages];
+
+        for (i = 0; i < numPagesInVM; ++ i) {
+            NewTranslation[i] = NachOSpageTable[i];
+        }
+        for (; i < newNumPages; ++ i) {
+            InitEntry(&NewTranslation[i], i);
+        }
+
+        delete [] NachOSpageTable;
+        NachOSpageTable = NewTranslation;
+    }
+
+    numPagesInVM = newNumPages;
+    NotePageTableSize();
+}
+
 //----------------------------------------------------------------------
 // ProcessAddrSpace::AddSharedSpace
 //  Appends Shared Memory, creates a new page table, copies old
@@ -197,55 +414,267 @@ void ProcessAddrSpace::CopyParentAddrSpace(ProcessAddrSpace *parentSpace) {
 //----------------------------------------------------------------------
 
 int ProcessAddrSpace::AddSharedSpace(int SharedSpaceSize) {
-    unsigned int i, numSharedPages = divRoundUp(SharedSpaceSize, PageSize);
-    TranslationEntry* NewTranslation = new TranslationEntry[numPagesInVM + numSharedPages];
+    unsigned int i, firstSharedPage = numPagesInVM;
+    unsigned int numSharedPages = divRoundUp(SharedSpaceSize, PageSize);
+
+    // Leave the guard page below the stack alone
+    if (numPagesInVM + numSharedPages >= StackBottomPage()) {
+        return -1;
+    }
+
+    ExtendPageTable(numSharedPages);
+
+    for (i = firstSharedPage; i < numPagesInVM; ++ i) {
+        TranslationEntry *entry = GetEntry(i);
+
+        entry->physicalPage = GetNextPageToWrite(i, -1);
+        bzero(&machine->mainMemory[(entry->physicalPage)*PageSize], PageSize);
+        entry->shared = TRUE;
+        entry->valid = TRUE;
+        entry->ifUsed = TRUE;
+
+        machine->isShared[entry->physicalPage] = 1;
+
+        // printf("Sharing phys at vpn %d: %d\n", NachOSpageTable[i].physicalPage, i);
+    }
+
+    RestoreStateOnSwitch();
+
+    return firstSharedPage * PageSize;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::GrowHeap
+//  Moves the heap break up by "increment" bytes and returns the old
+//  break, or -1 if the heap would exceed UserHeapMaxSize.  The new
+//  pages are only entered in the page table; PageFaultHandler
+//  hands out zeroed frames for them when they are first touched.
+//
+//  The heap lives at the end of the low part of the address space.
+//  If a shared segment was appended after it, the heap cannot grow in
+//  place, so the break restarts past the end of the shared segment.
+//  The heap never grows into the guard page below the stack.
+//----------------------------------------------------------------------
+
+int ProcessAddrSpace::GrowHeap(int increment) {
+    unsigned oldBreak;
+    unsigned heapEnd = divRoundUp(heapBreak, PageSize) * PageSize;
+
+    if ((increment < 0) || (heapSize + increment > UserHeapMaxSize)) {
+        return -1;
+    }
+
+    if ((heapBreak + increment > heapEnd) && (heapEnd != numPagesInVM * PageSize)) {
+        heapBreak = heapEnd = numPagesInVM * PageSize;
+    }
+
+    if (divRoundUp(heapBreak + increment, PageSize) >= StackBottomPage()) {
+        return -1;
+    }
+
+    oldBreak = heapBreak;
+    heapBreak += increment;
+    heapSize += increment;
+
+    if (heapBreak > heapEnd) {
+        ExtendPageTable(divRoundUp(heapBreak - heapEnd, PageSize));
+        RestoreStateOnSwitch();
+    }
 
-    for (i = 0; i < numPagesInVM; ++ i) {
-        NewTranslation[i].virtualPage = NachOSpageTable[i].virtualPage;
-        NewTranslation[i].physicalPage = NachOSpageTable[i].physicalPage;
+    return oldBreak;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::AllocateUserStack
+//  Returns the top of a UserThreadStackSize stack for a thread made by
+//  ThreadCreate, or -1 if the heap is full.  The stack is taken from
+//  the heap, page aligned, with one page below it left unmapped as a
+//  guard, so that an overflow faults instead of running into the heap
+//  or another thread's stack.  An exited thread's stack is handed out
+//  again first.
+//----------------------------------------------------------------------
+
+int ProcessAddrSpace::AllocateUserStack() {
+    unsigned stackSize = divRoundUp(UserThreadStackSize, PageSize) * PageSize;
+    int base;
+    unsigned guard;
 
-        NewTranslation[i].shared = NachOSpageTable[i].shared;
-        NewTranslation[i].valid = NachOSpageTable[i].valid;
-        NewTranslation[i].use = NachOSpageTable[i].use;
-        NewTranslation[i].dirty = NachOSpageTable[i].dirty;
-        NewTranslation[i].readOnly = NachOSpageTable[i].readOnly;
-        NewTranslation[i].ifUsed = NachOSpageTable[i].ifUsed;
+    if (numFreeUserStacks > 0) {
+        return freeUserStacks[--numFreeUserStacks];
+    }
+    if (numGuardPages == MaxUserStacks) {
+        return -1;
     }
+    // A page to align the stack, the guard page, and the stack
+    base = GrowHeap(stackSize + 2 * PageSize);
+    if (base == -1) {
+        return -1;
+    }
+    guard = divRoundUp(base, PageSize);
+    guardPages[numGuardPages++] = guard;
+    return (guard + 1) * PageSize + stackSize;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::IsGuardPage
+//  Is vpn the guard page below a thread stack?  It is never given a
+//  frame, so a reference to it is a segmentation fault.
+//----------------------------------------------------------------------
+
+bool ProcessAddrSpace::IsGuardPage(unsigned vpn) {
+    for (int i = 0; i < numGuardPages; i++) {
+        if (guardPages[i] == vpn) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::FreeUserStack
+//  Keeps the stack of an exited thread, whose top is "stackTop", for
+//  the next AllocateUserStack.  Its pages stay mapped.
+//----------------------------------------------------------------------
+
+void ProcessAddrSpace::FreeUserStack(int stackTop) {
+    ASSERT(numFreeUserStacks < MaxUserStacks);
+    freeUserStacks[numFreeUserStacks++] = stackTop;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::GrowStack
+//  Called on a fault outside both page tables.  If the fault is in
+//  the page just below the current stack bottom, or anywhere between
+//  the stack pointer and the stack bottom (a big stack frame), the
+//  stack page table is extended down to cover it.  The stack never
+//  grows past UserStackMaxSize, and the page just above the low part
+//  of the address space is kept unmapped as a guard, so a stack
+//  overflow faults instead of running into the heap.
+//
+//  The stack swap and the flat stack page table are grown by doubling,
+//  so a stack that grows page by page is not copied on every fault.
+//----------------------------------------------------------------------
+
+bool ProcessAddrSpace::GrowStack(unsigned virtAddr) {
+    unsigned vpn = virtAddr / PageSize;
+    unsigned bottom = StackBottomPage();
+    unsigned sp = (unsigned) machine->ReadRegister(StackReg);
+    unsigned i, newNumPages = UserStackTop/PageSize - vpn;
+
+    if ((vpn >= bottom) || ((vpn + 1 != bottom) && (virtAddr < sp))) {
+        return FALSE;
+    }
+    if ((vpn <= numPagesInVM) || (newNumPages * PageSize > UserStackMaxSize)) {
+        return FALSE;
+    }
+
+    if (newNumPages > stackCapacity) {
+        unsigned newCapacity = 2 * stackCapacity;
+
+        if (newCapacity > (unsigned) (UserStackMaxSize/PageSize)) {
+            newCapacity = UserStackMaxSize/PageSize;
+        }
+        if (newCapacity < newNumPages) {
+            newCapacity = newNumPages;
+        }
 
-    for (; i < numSharedPages + numPagesInVM; ++ i) {
-        NewTranslation[i].virtualPage = i;
-        NewTranslation[i].physicalPage = GetNextPageToWrite(i, -1);
-        bzero(&machine->mainMemory[(NewTranslation[i].physicalPage)*PageSize], PageSize);
-        NewTranslation[i].shared = TRUE;
-        NewTranslation[i].valid = TRUE;
-        NewTranslation[i].use = FALSE;
-        NewTranslation[i].dirty = FALSE;
-        NewTranslation[i].readOnly = FALSE;
-        NewTranslation[i].ifUsed = TRUE;
+        char *newSwapMemory = new char[newCapacity * PageSize];
 
-        machine->isShared[NewTranslation[i].physicalPage] = 1;
+        memcpy(newSwapMemory, stackSwapMemory, numStackPages * PageSize);
+        delete [] stackSwapMemory;
+        stackSwapMemory = newSwapMemory;
 
-        // printf("Sharing phys at vpn %d: %d\n", NewTranslation[i].physicalPage, i);
+        if (pageDirectory == NULL) {
+            TranslationEntry *newTable = new TranslationEntry[newCapacity];
+
+            for (i = 0; i < numStackPages; i++) {
+                newTable[i] = stackPageTable[i];
+            }
+            delete [] stackPageTable;
+            stackPageTable = newTable;
+        }
+        stackCapacity = newCapacity;
     }
 
-    numPagesInVM += numSharedPages;
+    for (i = numStackPages; i < newNumPages; i++) {
+        unsigned stackVpn = UserStackTop/PageSize - 1 - i;
 
-    delete NachOSpageTable;
+        if (pageDirectory != NULL) {
+            InitEntry(pageDirectory->Map(stackVpn), stackVpn);
+        } else {
+            InitEntry(&stackPageTable[i], stackVpn);
+        }
+    }
+    numStackPages = newNumPages;
+    NotePageTableSize();
 
-    NachOSpageTable = NewTranslation;
     RestoreStateOnSwitch();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::GetEntry, NewEntry, SwapSlot, VpnAt, EntryAt
+//  Hide how the page tables are organized: two flat tables, one for
+//  the low pages and one for the stack, or a single two-level table.
+//  GetEntry returns NULL for pages that are not mapped.  NewEntry
+//  returns the (uninitialized) entry for a page that is being added.
+//----------------------------------------------------------------------
+
+TranslationEntry* ProcessAddrSpace::GetEntry(unsigned vpn) {
+    if (pageDirectory != NULL) {
+        return pageDirectory->Lookup(vpn);
+    }
+    if (vpn < numPagesInVM) {
+        return &NachOSpageTable[vpn];
+    }
+    if ((vpn >= StackBottomPage()) && (vpn < (unsigned) (UserStackTop/PageSize))) {
+        return &stackPageTable[UserStackTop/PageSize - 1 - vpn];
+    }
+    return NULL;
+}
 
-    return (numPagesInVM - numSharedPages) * PageSize;
+char* ProcessAddrSpace::SwapSlot(unsigned vpn) {
+    if (vpn < numPagesInVM) {
+        return &swapMemory[vpn * PageSize];
+    }
+    return &stackSwapMemory[(UserStackTop/PageSize - 1 - vpn) * PageSize];
+}
+
+TranslationEntry* ProcessAddrSpace::NewEntry(unsigned vpn) {
+    if (pageDirectory != NULL) {
+        return pageDirectory->Map(vpn);
+    }
+    return GetEntry(vpn);
+}
+
+unsigned ProcessAddrSpace::VpnAt(unsigned i) {
+    if (i < numPagesInVM) {
+        return i;
+    }
+    return UserStackTop/PageSize - 1 - (i - numPagesInVM);
+}
+
+TranslationEntry* ProcessAddrSpace::EntryAt(unsigned i) {
+    return GetEntry(VpnAt(i));
 }
 
 bool ProcessAddrSpace::isVpnShared(int vpn) {
-    return NachOSpageTable[vpn].shared;
+    TranslationEntry *entry = GetEntry(vpn);
+    return (entry != NULL) && entry->shared;
+}
+
+// Pages past the code and initialized data (bss, stack and heap)
+// start out zeroed and never need the executable
+bool ProcessAddrSpace::IsBackedByExecutable(unsigned vpn) {
+    return (vpn * PageSize < (unsigned)(noffH.code.size + noffH.initData.size));
 }
 
 //----------------------------------------------------------------------
 // ProcessAddrSpace::GetNextPageToWrite
 //  Finds next page for page fault handler
-//  and write it to swap array if it was dirty
+//  and write it to swap array if it was dirty.  Whatever the
+//  replacement algorithm, a page that a MADV_SEQUENTIAL scan has
+//  already moved past goes first.
 //----------------------------------------------------------------------
 int ProcessAddrSpace::GetNextPageToWrite(int vpn, int notToReplace) {
     int i, foundPage = -1;
@@ -254,91 +683,107 @@ int ProcessAddrSpace::GetNextPageToWrite(int vpn, int notToReplace) {
     if (replacementAlgo == NO_REPL) {
         // If all pages have been allocated,
         // we cannot proceed
-        if(numPagesAllocated >= NumPhysPages) {
+        if(numPagesAllocated >= (unsigned) NumPhysPages) {
             // printf("%d %d\n", numPagesAllocated, NumPhysPages);
             ASSERT(false);
         }
     }
 
     // printf("[%d] wants a page for vpn %d\n", pid, vpn);
-    if (usedPages == NumPhysPages) {
-        switch(replacementAlgo) {
-            case RANDOM_REPL:
-                // printf("Entering random replacement algorithm\n");
-                foundPage = Random()%(NumPhysPages);
-
-                // If this is a shared page or not to be replaced, loop
-                while (machine->isShared[foundPage] ||
-                       foundPage == notToReplace) {
+    if (usedPages == (unsigned) NumPhysPages) {
+        foundPage = DroppedBehindFrame(notToReplace);
+        if (foundPage != -1) {
+            machine->referenceBit[foundPage] = TRUE;
+        } else {
+            switch(replacementAlgo) {
+                case RANDOM_REPL:
+                    // printf("Entering random replacement algorithm\n");
                     foundPage = Random()%(NumPhysPages);
-                };
 
-                break;
+                    // If this is a shared page or not to be replaced, loop
+                    while (machine->isShared[foundPage] ||
+                           machine->isLocked[foundPage] ||
+                           foundPage == notToReplace) {
+                        foundPage = Random()%(NumPhysPages);
+                    };
 
-            case LRU_CLOCK_REPL:
-                // printf("Entering clock lru replacement algorithm\n");
+                    break;
 
-                while(machine->referenceBit[LRU_Clock_ptr] ||
-                      machine->isShared[LRU_Clock_ptr] ||
-                      LRU_Clock_ptr == notToReplace) {
+                case LRU_CLOCK_REPL:
+                    // printf("Entering clock lru replacement algorithm\n");
 
-                    // printf("Ptr: %d, bit %d\n", LRU_Clock_ptr, machine->referenceBit[LRU_Clock_ptr]);
-                    machine->referenceBit[LRU_Clock_ptr] = 0;
-                    LRU_Clock_ptr = (LRU_Clock_ptr+1)%NumPhysPages;
-                }
+                    while(machine->referenceBit[LRU_Clock_ptr] ||
+                          machine->isShared[LRU_Clock_ptr] ||
+                          machine->isLocked[LRU_Clock_ptr] ||
+                          LRU_Clock_ptr == notToReplace) {
 
-                foundPage = LRU_Clock_ptr;
+                        // printf("Ptr: %d, bit %d\n", LRU_Clock_ptr, machine->referenceBit[LRU_Clock_ptr]);
+                        machine->referenceBit[LRU_Clock_ptr] = 0;
+                        LRU_Clock_ptr = (LRU_Clock_ptr+1)%NumPhysPages;
+                    }
 
-                // set the refernce Bit of replaced page
-                machine->referenceBit[foundPage]=TRUE;
+                    foundPage = LRU_Clock_ptr;
 
-                // Increment the Clock pointer
-                LRU_Clock_ptr = (LRU_Clock_ptr+1)%NumPhysPages;
-                break;
+                    // set the refernce Bit of replaced page
+                    machine->referenceBit[foundPage]=TRUE;
 
-            case LRU_REPL:
-                // printf("Entering lru replacement algorithm\n");
+                    // Increment the Clock pointer
+                    LRU_Clock_ptr = (LRU_Clock_ptr+1)%NumPhysPages;
+                    break;
 
-                if(notToReplace != -1) {
-                    machine->LRUTimeStamp[notToReplace] = stats->totalTicks-1;
-                }
+                case LRU_REPL:
+                    // printf("Entering lru replacement algorithm\n");
 
-                for(i = 0; i<NumPhysPages; i++){
-                    if( machine->LRUTimeStamp[i] < val  && machine->isShared[i] == FALSE  && i != notToReplace ){
-                        foundPage = i;
-                        val = machine->LRUTimeStamp[i];
+                    if(notToReplace != -1) {
+                        machine->LRUTimeStamp[notToReplace] = stats->totalTicks-1;
                     }
-                }
-                ASSERT(foundPage != -1);
 
-                machine->LRUTimeStamp[foundPage] = stats->totalTicks;
+                    for(i = 0; i<NumPhysPages; i++){
+                        if( machine->LRUTimeStamp[i] < val  && machine->isShared[i] == FALSE  && !machine->isLocked[i] && i != notToReplace ){
+                            foundPage = i;
+                            val = machine->LRUTimeStamp[i];
+                        }
+                    }
+                    ASSERT(foundPage != -1);
+
+                    machine->LRUTimeStamp[foundPage] = stats->totalTicks;
 
-                break;
-            case FIFO_REPL:
-                // printf("Entering FIFO replacement algorithm\n");
-
-                tmp = (int *)FIFOQueue->Remove();
-                foundPage = *tmp;
-                while (foundPage == notToReplace || machine->isShared[foundPage]) {
-                    if (foundPage == notToReplace) {
-                        tmp2 = tmp;
-                        tmp = (int *)FIFOQueue->Remove();
-                        foundPage = *tmp;
+                    break;
+                case FIFO_REPL:
+                    // printf("Entering FIFO replacement algorithm\n");
+
+                    tmp = (int *)FIFOQueue->Remove();
+                    foundPage = *tmp;
+                    while (foundPage == notToReplace || machine->isShared[foundPage] ||
+                           machine->isLocked[foundPage]) {
+                        if (machine->isLocked[foundPage]) {
+                            // Locked pages stay in the queue for when
+                            // they are unlocked
+                            FIFOQueue->Append((void *)tmp);
+                            tmp = (int *)FIFOQueue->Remove();
+                            foundPage = *tmp;
+                            continue;
+                        }
+                        if (foundPage == notToReplace) {
+                            tmp2 = tmp;
+                            tmp = (int *)FIFOQueue->Remove();
+                            foundPage = *tmp;
+                        }
+                        if(machine->isShared[foundPage]) {
+                            delete tmp;
+                            tmp = (int *)FIFOQueue->Remove();
+                            foundPage = *tmp;
+                        }
                     }
-                    if(machine->isShared[foundPage]) {
-                        delete tmp;
-                        tmp = (int *)FIFOQueue->Remove();
-                        foundPage = *tmp;
+                    if (tmp2) {
+                        FIFOQueue->Prepend((void *)tmp2);
                     }
-                }
-                if (tmp2) {
-                    FIFOQueue->Prepend((void *)tmp2);
-                }
 
-                ASSERT(foundPage != -1);
-                FIFOQueue->Append((void *)tmp);
-                // printf("FoundPage is %d\n", foundPage);
-                break;
+                    ASSERT(foundPage != -1);
+                    FIFOQueue->Append((void *)tmp);
+                    // printf("FoundPage is %d\n", foundPage);
+                    break;
+            }
         }
 
         // SWAPPING
@@ -375,8 +820,11 @@ int ProcessAddrSpace::GetNextPageToWrite(int vpn, int notToReplace) {
         usedPages++;
     }
 
+    machine->BreakLinkToFrame(foundPage);	// an LL into the old page
+    futexTable->WakeFrame(foundPage);		// and waiters on it
     machine->memoryUsedBy[foundPage] = this->pid;
     machine->virtualPageNo[foundPage] = vpn;
+    machine->LRUTimeStamp[foundPage] = stats->totalTicks;
 
     ASSERT(foundPage != -1);
 
@@ -385,41 +833,152 @@ int ProcessAddrSpace::GetNextPageToWrite(int vpn, int notToReplace) {
 }
 
 //----------------------------------------------------------------------
-// ProcessAddrSpace::PageFaultHandler
-// 	Handles Page fault for virtual page number vpn
-// 	Allocates physical page for it and copies the
-// 	required data from executable
+// ProcessAddrSpace::FillNewPage
+//  Gives frame "frame" the initial contents of virtual page vpn:
+//  the executable's bytes for code and initialized data, zeros
+//  otherwise
 //----------------------------------------------------------------------
 
-void ProcessAddrSpace::PageFaultHandler(unsigned virtAddr) {
-    // printf("[%d] Page fault for %d\n", currentThread->GetPID(), virtAddr);
+void ProcessAddrSpace::FillNewPage(unsigned vpn, unsigned frame) {
+    bzero(&(machine->mainMemory[frame*PageSize]), PageSize);
 
-    stats->numPageFaults ++;
+    if (IsBackedByExecutable(vpn)) {
+        OpenFile *executable = fileSystem->Open(fileName);
+        executable->ReadAt(&(machine->mainMemory[frame * PageSize]),
+                           PageSize, noffH.code.inFileAddr + vpn*PageSize);
+        delete executable;
+    }
+}
 
-    unsigned vpn = virtAddr/PageSize;
-    ASSERT(vpn <= numPagesInVM);
+//----------------------------------------------------------------------
+// ProcessAddrSpace::LargePageHead
+//  If vpn is part of a mapped large page, returns the entry that
+//  maps it (the entry of the large page's first page), else NULL
+//----------------------------------------------------------------------
+
+TranslationEntry* ProcessAddrSpace::LargePageHead(unsigned vpn) {
+    TranslationEntry *head = GetEntry(vpn - vpn % LargePageFactor);
+
+    if ((head != NULL) && head->valid && head->largePage) {
+        return head;
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::AllocateLargeFrames
+//  Finds LargePageFactor free, consecutive frames starting at a
+//  multiple of LargePageFactor.  Returns the first one, or -1.
+//  Large pages are never evicted, so only free frames are used.
+//  Without replacement, frames are handed out in order, and the
+//  ones skipped to reach an aligned start are lost.
+//----------------------------------------------------------------------
+
+int ProcessAddrSpace::AllocateLargeFrames() {
+    int base, i;
+
+    if (replacementAlgo == NO_REPL) {
+        base = divRoundUp(numPagesAllocated, LargePageFactor) * LargePageFactor;
+        if (base + LargePageFactor > NumPhysPages) {
+            return -1;
+        }
+        numPagesAllocated = base + LargePageFactor;
+    } else {
+        for (base = 0; base + LargePageFactor <= NumPhysPages; base += LargePageFactor) {
+            for (i = 0; i < LargePageFactor; i++) {
+                if (machine->memoryUsedBy[base + i] != -1) break;
+            }
+            if (i == LargePageFactor) break;
+        }
+        if (base + LargePageFactor > NumPhysPages) {
+            return -1;
+        }
+    }
+
+    usedPages += LargePageFactor;
+    return base;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::MapLargePage
+//  With -lp, a fault on code or data that has never been touched
+//  maps the whole aligned large page around vpn in one go: one
+//  fault and one disk wait instead of LargePageFactor of them, and
+//  a single translation entry.  Returns FALSE (and maps nothing) if
+//  the large page would stick out of code and data, any page in it
+//  has been used, or no aligned frames are free.  Large pages are
+//  pinned, and count against MaxLockedPages like MADV_LOCK.
+//----------------------------------------------------------------------
+
+bool ProcessAddrSpace::MapLargePage(unsigned vpn) {
+    unsigned first = vpn - vpn % LargePageFactor;
+    unsigned numLoadedPages = divRoundUp(noffH.code.size + noffH.initData.size
+                                         + noffH.uninitData.size, PageSize);
+    TranslationEntry *entry;
+    int frame, j;
+
+    if (!useLargePages || (first + LargePageFactor > numLoadedPages) ||
+        (machine->numLockedPages + LargePageFactor > MaxLockedPages)) {
+        return FALSE;
+    }
+    for (j = 0; j < LargePageFactor; j++) {
+        entry = GetEntry(first + j);
+        if ((entry == NULL) || entry->valid || entry->ifUsed ||
+            entry->shared || entry->locked || (entry->advice == MADV_RANDOM)) {
+            return FALSE;
+        }
+    }
+
+    frame = AllocateLargeFrames();
+    if (frame == -1) {
+        return FALSE;
+    }
+
+    for (j = 0; j < LargePageFactor; j++) {
+        machine->BreakLinkToFrame(frame + j);
+        futexTable->WakeFrame(frame + j);
+        machine->memoryUsedBy[frame + j] = pid;
+        machine->virtualPageNo[frame + j] = first + j;
+        machine->isLocked[frame + j] = TRUE;
+        machine->numLockedPages++;
+        FillNewPage(first + j, frame + j);
+        GetEntry(first + j)->ifUsed = TRUE;
+    }
+
+    entry = GetEntry(first);
+    entry->physicalPage = frame;
+    entry->valid = TRUE;
+    entry->dirty = TRUE;
+    entry->largePage = TRUE;
+
+    stats->numLargePages++;
+    return TRUE;
+}
 
+//----------------------------------------------------------------------
+// ProcessAddrSpace::LoadPage
+//  Gives virtual page vpn (whose entry is "entry") a physical page,
+//  never taking "notToReplace", and fills it from the executable,
+//  from swap, or with zeros.  The caller charges the disk wait.
+//----------------------------------------------------------------------
+
+void ProcessAddrSpace::LoadPage(unsigned vpn, TranslationEntry *entry, int notToReplace) {
     unsigned offset, i;
     unsigned startVirtAddr = PageSize * vpn;
     unsigned endVirtAddr = startVirtAddr + PageSize;
 
-    unsigned newPhysPage = GetNextPageToWrite(vpn, -1);
+    unsigned newPhysPage = GetNextPageToWrite(vpn, notToReplace);
 
     // Modify the contents of Page Table Entry for Virtual Page vpn
-    NachOSpageTable[vpn].physicalPage = newPhysPage;
-    NachOSpageTable[vpn].valid = TRUE;
-
-    bzero(&(machine->mainMemory[newPhysPage*PageSize]), PageSize);
-
-    OpenFile *executable = fileSystem->Open(fileName);
+    entry->physicalPage = newPhysPage;
+    entry->valid = TRUE;
 
-    if (!NachOSpageTable[vpn].ifUsed) {
+    if (!entry->ifUsed) {
         unsigned start = max(startVirtAddr, noffH.code.virtualAddr);
         unsigned end = min(endVirtAddr, noffH.code.virtualAddr+noffH.code.size);
 
         // A simplified approach to copying the page to memory
-        executable->ReadAt(&(machine->mainMemory[newPhysPage * PageSize]),
-                           PageSize, noffH.code.inFileAddr + vpn*PageSize);
+        FillNewPage(vpn, newPhysPage);
 
         // For sake of complete correctness, this is the ideal copying
         // methodology:
@@ -441,21 +1000,92 @@ void ProcessAddrSpace::PageFaultHandler(unsigned virtAddr) {
         }
         */
 
-        NachOSpageTable[vpn].dirty = 1;
+        entry->dirty = 1;
         // printf("[%d] Used first time vpn:%d at phys: %d\n", pid, vpn, newPhysPage);
     } else {
         // Get this from swap memory
-        memcpy(&(machine->mainMemory[newPhysPage*PageSize]), &(swapMemory[vpn*PageSize]), PageSize);
+        memcpy(&(machine->mainMemory[newPhysPage*PageSize]), SwapSlot(vpn), PageSize);
     }
 
-    delete executable;
-    NachOSpageTable[vpn].ifUsed = 1;
+    entry->ifUsed = 1;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::PageFaultHandler
+// 	Handles Page fault for virtual address virtAddr
+// 	Allocates physical page for it and copies the
+// 	required data from executable.  A fault below the stack
+// 	grows the stack first.  Returns FALSE if the address is
+// 	not part of the address space (or hits the guard page).
+//----------------------------------------------------------------------
+
+bool ProcessAddrSpace::PageFaultHandler(unsigned virtAddr) {
+    // printf("[%d] Page fault for %d\n", currentThread->GetPID(), virtAddr);
+
+    unsigned vpn = virtAddr/PageSize;
+    TranslationEntry *entry = GetEntry(vpn);
+
+#ifdef USE_TLB
+    // Most traps are TLB misses on pages that are in memory; those
+    // only need the translation loaded into the TLB
+    TranslationEntry *resident = LargePageHead(vpn);
+    if ((resident == NULL) && (entry != NULL) && entry->valid) {
+        resident = entry;
+    }
+    if (resident != NULL) {
+        tlbManager->Refill(pid, resident);
+        return TRUE;
+    }
+#endif
+
+    if (entry == NULL) {
+        if (!GrowStack(virtAddr)) {
+            return FALSE;
+        }
+        entry = GetEntry(vpn);
+        ASSERT(entry != NULL);
+    } else if (IsGuardPage(vpn)) {
+        return FALSE;                   // a thread stack overflowed
+    }
+
+    stats->numPageFaults ++;
+    currentThread->IncPageFaultCount();
+
+    if (MapLargePage(vpn)) {
+        currentThread->SortedInsertInWaitQueue (1000+stats->totalTicks);
+        return TRUE;
+    }
+
+    LoadPage(vpn, entry, -1);
+
+    if (entry->advice == MADV_SEQUENTIAL) {
+        // Read ahead: the next pages are most likely wanted soon, and
+        // come in with the same disk wait as this one
+        for (unsigned i = 1; i <= FaultAroundPages; i++) {
+            TranslationEntry *next = GetEntry(vpn + i);
+            if ((next == NULL) || next->valid || next->shared ||
+                (next->advice != MADV_SEQUENTIAL) || !CanLoadMore() ||
+                (LargePageHead(vpn + i) != NULL)) {
+                break;
+            }
+            LoadPage(vpn + i, next, entry->physicalPage);
+        }
+
+        // Drop behind: the page before this one will not be needed
+        // again, so make it the next victim (until it is touched)
+        TranslationEntry *prev = (vpn > 0) ? GetEntry(vpn - 1) : NULL;
+        if ((prev != NULL) && prev->valid && !prev->shared && !prev->locked) {
+            machine->LRUTimeStamp[prev->physicalPage] = DroppedBehind;
+            machine->referenceBit[prev->physicalPage] = FALSE;
+        }
+    }
 
     // printf("[%d] Going to sleep\n", pid);
     currentThread->SortedInsertInWaitQueue (1000+stats->totalTicks);
     // printf("[%d] Returned from sleep\n", pid);
     // printf("Was faulting on vpn: %d\n", vpn);
     // printf("It is now at phys: %d\n", NachOSpageTable[vpn].physicalPage);
+    return TRUE;
 }
 
 
@@ -470,40 +1100,252 @@ void ProcessAddrSpace::PageFaultHandler(unsigned virtAddr) {
 void ProcessAddrSpace::SaveToSwap(int vpn) {
     // printf("[%d] Saving vpn:%d, phys:%d to swap\n", pid, vpn, NachOSpageTable[vpn].physicalPage);
 
-    // Physical Page should Exist
-    ASSERT(NachOSpageTable[vpn].valid);
+    TranslationEntry *entry = GetEntry(vpn);
+
+#ifdef USE_TLB
+    tlbManager->InvalidatePage(pid, vpn);	// picks up the dirty bit
+#endif
 
-    if (NachOSpageTable[vpn].dirty) {
-        unsigned pageFrame = NachOSpageTable[vpn].physicalPage;
-        memcpy(&(swapMemory[vpn*PageSize]), &(machine->mainMemory[pageFrame*PageSize]),
+    // Physical Page should Exist, and may not be pinned
+    ASSERT(entry != NULL && entry->valid);
+    ASSERT(!entry->locked);
+
+    if (entry->dirty) {
+        unsigned pageFrame = entry->physicalPage;
+        memcpy(SwapSlot(vpn), &(machine->mainMemory[pageFrame*PageSize]),
                PageSize);
-        NachOSpageTable[vpn].dirty = FALSE;
+        entry->dirty = FALSE;
     }
 
     // Set Translation Entry's variables
-    NachOSpageTable[vpn].physicalPage = -1;
-    NachOSpageTable[vpn].valid = FALSE;
+    entry->physicalPage = -1;
+    entry->valid = FALSE;
 }
 
 //----------------------------------------------------------------------
-// ProcessAddrSpace::~ProcessAddrSpace
-//  Dealloate an address space.  Nothing for now!
+// ProcessAddrSpace::ReleasePhysicalPages
+//  Gives back every frame this space holds, except shared ones.
+//  Safe to call more than once.
 //----------------------------------------------------------------------
 
-ProcessAddrSpace::~ProcessAddrSpace()
-{
+void ProcessAddrSpace::ReleasePhysicalPages() {
     int physPageNumber;
-    for(int i = 0; i < numPagesInVM; i++) {
-        if (!NachOSpageTable[i].shared && NachOSpageTable[i].valid) {
-            physPageNumber = NachOSpageTable[i].physicalPage;
+    TranslationEntry *entry;
+
+#ifdef USE_TLB
+    tlbManager->WriteBack(pid, TRUE);
+#endif
+
+    for (unsigned i = 0; i < NumEntries(); i++) {
+        entry = EntryAt(i);
+        if (entry->valid && entry->largePage) {
+            for (int j = 0; j < LargePageFactor; j++) {
+                physPageNumber = entry->physicalPage + j;
+                machine->memoryUsedBy[physPageNumber] = -1;
+                machine->virtualPageNo[physPageNumber] = -1;
+                machine->isLocked[physPageNumber] = FALSE;
+                machine->numLockedPages--;
+            }
+            usedPages -= LargePageFactor;
+            entry->valid = FALSE;
+            entry->largePage = FALSE;
+            continue;
+        }
+        if (entry->locked) {
+            UnlockPage(entry);
+        }
+        if (!entry->shared && entry->valid) {
+            physPageNumber = entry->physicalPage;
             machine->memoryUsedBy[physPageNumber] = -1;
             machine->virtualPageNo[physPageNumber] = -1;
             usedPages--;
+            entry->valid = FALSE;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::CanLoadMore
+//  Without page replacement a frame is never given back, so read
+//  ahead and prefetching must not use up the last frames.
+//----------------------------------------------------------------------
+
+bool ProcessAddrSpace::CanLoadMore() {
+    return (replacementAlgo != NO_REPL) || (numPagesAllocated < (unsigned) NumPhysPages);
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::DroppedBehindFrame
+//  Returns a frame that may be replaced and whose page was dropped
+//  behind by a MADV_SEQUENTIAL fault and not touched since, or -1.
+//  Touching the page (Translate) or reusing the frame overwrites its
+//  DroppedBehind stamp.
+//----------------------------------------------------------------------
+
+int ProcessAddrSpace::DroppedBehindFrame(int notToReplace) {
+    for (int i = 0; i < NumPhysPages; i++) {
+        if ((machine->LRUTimeStamp[i] == DroppedBehind) &&
+            (machine->memoryUsedBy[i] != -1) && !machine->isShared[i] &&
+            !machine->isLocked[i] && (i != notToReplace)) {
+            return i;
         }
     }
-    delete fileName;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::DropPage
+//  MADV_DONTNEED: gives the frame back without writing it to swap.
+//  The page is marked never used, so its next fault brings in a
+//  zeroed page (or the executable's copy, for code and data).
+//  Without page replacement a freed frame is never handed out again,
+//  so there the page keeps its frame and just gets its first
+//  contents back.
+//----------------------------------------------------------------------
+
+void ProcessAddrSpace::DropPage(TranslationEntry *entry) {
+#ifdef USE_TLB
+    tlbManager->InvalidatePage(pid, entry->virtualPage);
+#endif
+    if (entry->valid && (replacementAlgo == NO_REPL)) {
+        FillNewPage(entry->virtualPage, entry->physicalPage);
+        entry->dirty = FALSE;
+        return;
+    }
+    if (entry->valid) {
+        machine->memoryUsedBy[entry->physicalPage] = -1;
+        machine->virtualPageNo[entry->physicalPage] = -1;
+        usedPages--;
+    }
+    entry->physicalPage = -1;
+    entry->valid = FALSE;
+    entry->dirty = FALSE;
+    entry->ifUsed = FALSE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::LockPage, UnlockPage
+//  Pin or unpin the (resident) frame of a page.  GetNextPageToWrite
+//  never picks a pinned frame.
+//----------------------------------------------------------------------
+
+void ProcessAddrSpace::LockPage(TranslationEntry *entry) {
+    ASSERT(entry->valid && !entry->locked);
+    entry->locked = TRUE;
+    machine->isLocked[entry->physicalPage] = TRUE;
+    machine->numLockedPages++;
+}
+
+void ProcessAddrSpace::UnlockPage(TranslationEntry *entry) {
+    ASSERT(entry->valid && entry->locked);
+    entry->locked = FALSE;
+    machine->isLocked[entry->physicalPage] = FALSE;
+    machine->numLockedPages--;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::Advise
+//  Applies a MADV_ hint (see syscall.h) to every page overlapping
+//  the "size" bytes starting at "addr".  Pages brought in by
+//  MADV_WILLNEED and MADV_LOCK share a single disk wait, which is
+//  what makes prefetching cheaper than faulting.  Shared pages are
+//  always resident, so locking and dropping leave them alone.
+//
+//  Returns 0, or -1 if part of the range is not mapped, the hint is
+//  unknown, or locking would pin more than MaxLockedPages frames.
+//----------------------------------------------------------------------
+
+int ProcessAddrSpace::Advise(unsigned addr, unsigned size, int advice) {
+    unsigned vpn, firstVpn, lastVpn, numToLock = 0, numLoaded = 0;
+    TranslationEntry *entry;
+
+    if ((size == 0) || (advice < MADV_NORMAL) || (advice > MADV_UNLOCK)) {
+        return -1;
+    }
+    firstVpn = addr / PageSize;
+    lastVpn = (addr + size - 1) / PageSize;
+    if (lastVpn < firstVpn) {
+        return -1;
+    }
+
+    for (vpn = firstVpn; vpn <= lastVpn; vpn++) {
+        entry = GetEntry(vpn);
+        if ((entry == NULL) || IsGuardPage(vpn)) {
+            return -1;
+        }
+        if (!entry->shared && !entry->locked && (LargePageHead(vpn) == NULL)) {
+            numToLock++;
+        }
+    }
+    if ((advice == MADV_LOCK) &&
+        (machine->numLockedPages + numToLock > (unsigned) MaxLockedPages)) {
+        return -1;
+    }
+
+    for (vpn = firstVpn; vpn <= lastVpn; vpn++) {
+        entry = GetEntry(vpn);
+        if (LargePageHead(vpn) != NULL) {
+            continue;           // always resident, and cannot be split
+        }
+        switch (advice) {
+            case MADV_NORMAL:
+            case MADV_SEQUENTIAL:
+            case MADV_RANDOM:
+                entry->advice = advice;
+                break;
+
+            case MADV_WILLNEED:
+            case MADV_LOCK:
+                if (!entry->valid) {
+                    if ((advice == MADV_WILLNEED) && !CanLoadMore()) {
+                        break;
+                    }
+                    LoadPage(vpn, entry, -1);
+                    numLoaded++;
+                }
+                // Pin each page as soon as it is in, so that loading
+                // the rest of the range cannot evict it
+                if ((advice == MADV_LOCK) && !entry->shared && !entry->locked) {
+                    LockPage(entry);
+                }
+                break;
+
+            case MADV_UNLOCK:
+                if (entry->locked) {
+                    UnlockPage(entry);
+                }
+                break;
+
+            case MADV_DONTNEED:
+                if (!entry->shared && !entry->locked) {
+                    DropPage(entry);
+                }
+                break;
+        }
+    }
+
+    if (numLoaded > 0) {
+        currentThread->SortedInsertInWaitQueue (1000+stats->totalTicks);
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::~ProcessAddrSpace
+//  Deallocate an address space: its frames, swap, page tables and
+//  open files.
+//----------------------------------------------------------------------
+
+ProcessAddrSpace::~ProcessAddrSpace()
+{
+    ReleasePhysicalPages();
+    delete files;
+    delete [] fileName;
     delete [] swapMemory;
-    delete NachOSpageTable;
+    delete [] stackSwapMemory;
+    delete [] NachOSpageTable;
+    delete [] stackPageTable;
+    delete pageDirectory;
 }
 
 //----------------------------------------------------------------------
@@ -531,11 +1373,54 @@ ProcessAddrSpace::InitUserCPURegisters()
     // of branch delay possibility
     machine->WriteRegister(NextPCReg, 4);
 
-   // Set the stack register to the end of the address space, where we
-   // allocated the stack; but subtract off a bit, to make sure we don't
-   // accidentally reference off the end!
-    machine->WriteRegister(StackReg, numPagesInVM * PageSize - 16);
-    DEBUG('a', "Initializing stack register to %d\n", numPagesInVM * PageSize - 16);
+   // Set the stack register to the top of the stack segment; but
+   // subtract off a bit, to make sure we don't accidentally reference
+   // off the end!
+    machine->WriteRegister(StackReg, UserStackTop - 16);
+    DEBUG('a', "Initializing stack register to %d\n", UserStackTop - 16);
+}
+
+//----------------------------------------------------------------------
+// ProcessAddrSpace::PushArguments
+// 	Copy the "argc" strings of "argv" to the top of the user stack,
+//	followed by the NULL terminated array of pointers to them, and
+//	pass both to main in r4 and r5.  This must be the current address
+//	space, just after InitUserCPURegisters.
+//
+//	The stack pointer is moved below everything first, so that the
+//	stack grows to cover the copy; at most MaxUserArgs strings of
+//	MaxUserString bytes always fit in UserStackMaxSize.
+//----------------------------------------------------------------------
+
+void
+ProcessAddrSpace::PushArguments(int argc, char **argv)
+{
+    int argvAddr[MaxUserArgs + 1];
+    int i, length, size = 0;
+    int sp = UserStackTop - 16;
+    bool copied;
+
+    ASSERT((argc >= 0) && (argc <= MaxUserArgs));
+    for (i = 0; i < argc; i++)
+	size += strlen(argv[i]) + 1;
+    size = divRoundUp(size, 4) * 4 + (argc + 1) * 4;
+    machine->WriteRegister(StackReg, sp - size - 16);	// room for main
+							// to save r4-r7
+
+    for (i = 0; i < argc; i++) {
+	length = strlen(argv[i]) + 1;
+	sp -= length;
+	copied = CopyToUser(sp, argv[i], length);
+	ASSERT(copied);
+	argvAddr[i] = WordToMachine(sp);
+    }
+    argvAddr[argc] = 0;
+    sp = (sp & ~3) - (argc + 1) * 4;
+    copied = CopyToUser(sp, (char *) argvAddr, (argc + 1) * 4);
+    ASSERT(copied);
+
+    machine->WriteRegister(4, argc);
+    machine->WriteRegister(5, sp);
 }
 
 //----------------------------------------------------------------------
@@ -561,6 +1446,13 @@ void ProcessAddrSpace::RestoreStateOnSwitch()
 {
     machine->NachOSpageTable = NachOSpageTable;
     machine->NachOSpageTableSize = numPagesInVM;
+    machine->stackPageTable = stackPageTable;
+    machine->stackPageTableSize = numStackPages;
+    machine->stackPageTableTop = UserStackTop/PageSize;
+    machine->pageDirectory = pageDirectory;
+
+    // TLB entries are tagged with the pid, so they need no flush
+    machine->currentASID = pid;
 }
 
 unsigned
@@ -568,9 +1460,3 @@ ProcessAddrSpace::GetNumPages()
 {
    return numPagesInVM;
 }
-
-TranslationEntry*
-ProcessAddrSpace::GetPageTable()
-{
-   return NachOSpageTable;
-}
@@ -16,8 +16,26 @@
 #include "copyright.h"
 #include "filesys.h"
 #include "noff.h"
-
-#define UserStackSize		1024 	// increase this as necessary!
+#include "pagetable.h"
+
+#define UserStackTop		0x00800000	// the stack grows down from here
+#define UserStackInitialSize	256	// bytes of stack mapped at startup
+#define UserStackMaxSize	(64 * 1024)	// the stack may grow this far
+#define UserHeapMaxSize		(256 * 1024)	// upper bound on the bytes a
+						// process can add with Sbrk
+#define UserThreadStackSize	(8 * 1024)	// stack of each thread made by
+						// ThreadCreate, out of the heap
+#define MaxUserStacks		(UserHeapMaxSize / UserThreadStackSize)
+#define FaultAroundPages	4	// pages read ahead on a fault in
+					// a MADV_SEQUENTIAL range
+#define DroppedBehind		(-1)	// LRUTimeStamp of a frame whose
+					// page a sequential scan has passed
+#define MaxLockedPages		(NumPhysPages / 2)	// MADV_LOCK and large
+							// pages may pin at most
+							// this many frames
+
+class CheckpointFile;
+class FileTable;
 
 class ProcessAddrSpace {
   public:
@@ -28,12 +46,18 @@ class ProcessAddrSpace {
 
     ProcessAddrSpace (ProcessAddrSpace *parentSpace, int pid);	// Used by fork
 
+    ProcessAddrSpace (CheckpointFile *file, int pid);	// Used to restore
+							// a checkpoint
+
     ~ProcessAddrSpace();			// De-allocate an address space
 
     void CopyParentAddrSpace(ProcessAddrSpace *parentSpace);
 
     void InitUserCPURegisters();		// Initialize user-level CPU registers,
         					// before jumping to user code
+    void PushArguments(int argc, char **argv);	// Put main's argc and argv
+						// on the stack, after
+						// InitUserCPURegisters
 
     void SaveStateOnSwitch();			// Save/restore address space-specific
     void RestoreStateOnSwitch();		// info on a context switch
@@ -44,14 +68,43 @@ class ProcessAddrSpace {
     unsigned GetNumPages();
 
     int AddSharedSpace(int SharedSpaceSize);    // appends SharedSPaceSize bytes of
-                                                // shared memory
+                                                // shared memory, returns -1 if
+                                                // it would run into the stack
+
+    int GrowHeap(int increment);                // moves the heap break up by
+                                                // increment bytes, returns the
+                                                // old break or -1
     void SaveToSwap(int virtualpagenumber);     // save this page to swap memory
                                                 // so that next page can be brought
 
-    TranslationEntry* GetPageTable();
+    bool PageFaultHandler(unsigned virtAddr);   // Allocates Physical Page for virtual
+                                                // address virtAddr, growing the
+                                                // stack if needed. Returns FALSE
+                                                // if virtAddr is not mapped
+
+    void ReleasePhysicalPages();                // Frees every private frame
+                                                // of this space
+
+    void AttachThread() { numThreads++; }       // Another thread runs here
+    int DetachThread() { return --numThreads; } // A thread is done with the
+                                                // space; returns how many
+                                                // are left
+    int NumThreads() { return numThreads; }
+
+    int AllocateUserStack();                    // Top of a stack for a new
+                                                // thread, or -1 if the heap
+                                                // is full
+    void FreeUserStack(int stackTop);           // Keeps an exited thread's
+                                                // stack for the next one
 
-    void PageFaultHandler(unsigned vpn);        // Allocates Physical Page for virtual
-                                                // page number vpn
+    void Checkpoint(CheckpointFile *file);      // Writes the page tables
+                                                // and swap to a checkpoint
+
+    TranslationEntry *GetEntry(unsigned vpn);   // NULL if vpn is not mapped
+
+    int Advise(unsigned addr, unsigned size, int advice);
+                                                // Applies a MADV_ hint to
+                                                // a range, returns 0 or -1
 
     char *fileName;                     // Store a pointer to the executable
                                         // our program is stored in
@@ -59,15 +112,84 @@ class ProcessAddrSpace {
     bool isVpnShared(int vpn);  // Returns if the asked vpn is a
                                 // shared one
 
+    FileTable *files;                   // open files; NULL once the
+                                        // process has exited
+
     char *swapMemory;
     int pid;
                                                 // used while forking
     NoffHeader noffH;                           // stores the noffHeader data
   private:
+    void ExtendPageTable(unsigned numNewPages);  // appends numNewPages invalid
+                                                // entries to the page table
+
+    bool GrowStack(unsigned virtAddr);          // maps the stack down to virtAddr
+
+    void LoadPage(unsigned vpn, TranslationEntry *entry, int notToReplace);
+                                                // gives vpn a frame and fills it
+    void DropPage(TranslationEntry *entry);     // frees vpn's frame, forgets
+                                                // its contents
+    void LockPage(TranslationEntry *entry);
+    void UnlockPage(TranslationEntry *entry);
+    bool CanLoadMore();                         // may prefetching take a frame?
+    int DroppedBehindFrame(int notToReplace);   // a frame a sequential scan
+                                                // has passed, or -1
+
+    void FillNewPage(unsigned vpn, unsigned frame);
+                                                // first contents of vpn
+    bool MapLargePage(unsigned vpn);            // maps vpn's large page, if
+                                                // large pages are on (-lp)
+    int AllocateLargeFrames();                  // aligned free frames, or -1
+    TranslationEntry *LargePageHead(unsigned vpn);
+                                                // entry of the large page
+                                                // holding vpn, or NULL
+
+    unsigned StackBottomPage() { return UserStackTop/PageSize - numStackPages; }
+
+    void AllocatePageTables(bool twoLevel);     // empty tables for the
+                                                // current sizes
+    void InitEntry(TranslationEntry *entry, unsigned vpn);
+    void NotePageTableSize();                   // updates the statistics
+
+    TranslationEntry *NewEntry(unsigned vpn);   // entry for a page being added
+    char *SwapSlot(unsigned vpn);               // where vpn lives when swapped out
+
+    // Every mapped page, the low part first, then the stack from
+    // the top down
+    unsigned NumEntries() { return numPagesInVM + numStackPages; }
+    unsigned VpnAt(unsigned i);
+    TranslationEntry *EntryAt(unsigned i);
+
+    bool IsBackedByExecutable(unsigned vpn);    // Does this page get its first
+                                                // contents from the executable?
+
     TranslationEntry *NachOSpageTable;	// Assume linear page table translation
 					// for now!
     unsigned int numPagesInVM;		// Number of pages in the virtual
 					// address space
+
+    unsigned heapBreak;                 // Current end of the heap (virtual address)
+    unsigned heapSize;                  // Bytes added to the heap so far
+
+    TranslationEntry *stackPageTable;   // Stack pages, from the page just
+                                        // below UserStackTop downwards
+    unsigned int numStackPages;         // Number of stack pages mapped so far
+    unsigned int stackCapacity;         // Pages stackSwapMemory (and the flat
+                                        // stackPageTable) have room for
+    char *stackSwapMemory;              // Swap for the stack pages, in the
+                                        // same order as stackPageTable
+
+    TwoLevelPageTable *pageDirectory;   // With -T 1, holds every entry
+                                        // instead of the two flat tables
+
+    int numThreads;                     // Threads running in this space;
+                                        // its frames and files are
+                                        // released when the last exits
+    int freeUserStacks[MaxUserStacks];
+    int numFreeUserStacks;              // Stacks of exited threads
+    unsigned guardPages[MaxUserStacks]; // The unmapped page below each
+    int numGuardPages;                  // thread stack
+    bool IsGuardPage(unsigned vpn);
 };
 
 #endif // ADDRSPACE_H
@@ -0,0 +1,185 @@
+// branch.cc
+//	Routines to carry a simulation on under several policies, in
+//	host child processes.  See branch.h.
+//
+//	A child switches policies the way a restored checkpoint does
+//	(ChangePolicies), and runs to the end.  In place of exiting,
+//	Cleanup calls EndOfBranch, which sends the statistics back to
+//	the parent through a pipe.  A child that dies on the way sends
+//	nothing, and is reported as not finished.
+//
+//	Branching from a simulation that runs under -sweep is not
+//	supported: the children would only have the host thread that
+//	forked them.  Initialize ignores -branch in a sweep job.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "checkpoint.h"
+#include "sweep.h"
+#include "branch.h"
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+static SimulationLocal int resultPipe;	// in a child, where to send
+					// its statistics
+
+//----------------------------------------------------------------------
+// BranchIsDue
+// 	Has the simulation reached the tick, or made the number of
+//	system calls, given with -branch?
+//----------------------------------------------------------------------
+
+bool
+BranchIsDue()
+{
+    if (branchPolicies == NULL)
+	return FALSE;
+    if (branchSyscall > 0)
+	return (stats->numSyscalls >= branchSyscall);
+    return (stats->totalTicks >= branchTick);
+}
+
+//----------------------------------------------------------------------
+// ParsePolicies
+// 	Turn the -branch policy list into scheduling and replacement
+//	algorithms.  Returns the number of policies, or 0 if the list
+//	is not valid.
+//----------------------------------------------------------------------
+
+static int
+ParsePolicies(char *list, int *sched, int *repl)
+{
+    char *copy = new char[strlen(list) + 1];
+    char *item, *rest, *slash;
+    int n = 0, a, r;
+
+    if (!strcmp(list, "*")) {
+	for (a = NON_PREEMPTIVE_BASE; a <= UNIX_SCHED; a++) {
+	    for (r = NO_REPL; r <= LRU_CLOCK_REPL; r++) {
+		sched[n] = a;
+		repl[n++] = r;
+	    }
+	}
+	delete [] copy;
+	return n;
+    }
+
+    strcpy(copy, list);
+    for (item = strtok_r(copy, ",", &rest); item != NULL;
+					item = strtok_r(NULL, ",", &rest)) {
+	slash = strchr(item, '/');
+	if ((slash == NULL) || (n == MaxBranches)) {
+	    n = 0;
+	    break;
+	}
+	*slash = '\0';
+	a = strcmp(item, "-") ? atoi(item) : schedulingAlgo;
+	r = strcmp(slash + 1, "-") ? atoi(slash + 1) : replacementAlgo;
+	if ((a < NON_PREEMPTIVE_BASE) || (a > UNIX_SCHED) ||
+				(r < NO_REPL) || (r > LRU_CLOCK_REPL)) {
+	    n = 0;
+	    break;
+	}
+	sched[n] = a;
+	repl[n++] = r;
+    }
+    delete [] copy;
+    return n;
+}
+
+//----------------------------------------------------------------------
+// EndOfBranch
+// 	Called by Cleanup in a child in place of exiting, once its
+//	simulation has halted.  Send the statistics to the parent.
+//----------------------------------------------------------------------
+
+static void
+EndOfBranch()
+{
+    SweepResult result;
+    int done;
+
+    result.Record();
+    fflush(stdout);
+    done = write(resultPipe, &result, sizeof(result));
+    ASSERT(done == sizeof(result));
+    close(resultPipe);
+    Exit(0);
+}
+
+//----------------------------------------------------------------------
+// Branch
+// 	Fork one host child process per policy given with -branch.
+//	Called on entry to a system call, when CheckpointIsSafe.
+//
+//	In a child, switch to its policies and return, to carry on with
+//	the system call.  The parent waits for every child, prints the
+//	table of their statistics, and exits.
+//----------------------------------------------------------------------
+
+void
+Branch()
+{
+    int sched[MaxBranches], repl[MaxBranches];
+    int pipes[MaxBranches];
+    SweepResult results[MaxBranches];
+    char label[32], outName[32];
+    int numBranches, i, fds[2], err;
+    pid_t child;
+
+    numBranches = ParsePolicies(branchPolicies, sched, repl);
+    branchPolicies = NULL;			// only branch once
+    if (numBranches == 0) {
+	printf("Bad -branch policy list; give <A>/<R>[,<A>/<R>...] or *\n");
+	return;
+    }
+
+    printf("[%d] Branching into %d policies after %d system calls\n",
+	   stats->totalTicks, numBranches, stats->numSyscalls);
+    for (i = 0; i < numBranches; i++) {
+	err = pipe(fds);
+	ASSERT(err == 0);
+	fflush(NULL);				// or the child writes it again
+	child = fork();
+	ASSERT(child != -1);
+	if (child == 0) {
+	    close(fds[0]);
+	    resultPipe = fds[1];
+	    sprintf(outName, "branch%d.out", i);
+	    if (freopen(outName, "w", stdout) == NULL)
+		fprintf(stderr, "Unable to create %s\n", outName);
+	    endSimulation = EndOfBranch;
+	    if ((inputLog != NULL) && inputLog->IsRecording())
+		inputLog = NULL;		// the parent's recording
+	    ChangePolicies(sched[i], repl[i]);
+	    return;
+	}
+	close(fds[1]);
+	pipes[i] = fds[0];
+    }
+
+    for (i = 0; i < numBranches; i++) {
+	results[i].finished = FALSE;
+	if (read(pipes[i], &results[i], sizeof(SweepResult)) !=
+						(int) sizeof(SweepResult))
+	    results[i].finished = FALSE;
+	close(pipes[i]);
+    }
+    while (wait(NULL) > 0)
+	;
+
+    printf("\nBranch: %d policies from tick %d\n", numBranches,
+	   stats->totalTicks);
+    PrintSweepHeader();
+    for (i = 0; i < numBranches; i++) {
+	sprintf(label, "-A %d -R %d", sched[i], repl[i]);
+	PrintSweepRow(i, &results[i], label);
+    }
+    fflush(stdout);
+    Exit(0);
+}
@@ -0,0 +1,40 @@
+// branch.h
+//	Interface to policy branching: run a simulation up to some point,
+//	then carry it on under several policies at once, each in a host
+//	child process of its own, and compare how they did.
+//
+//	  nachos ... -branch <when> <policies>
+//
+//	<when> is a tick, or "@n" for the n-th system call.  The branch
+//	is made at the first system call from then on where a checkpoint
+//	could be taken (see checkpoint.h), so every child starts from
+//	exactly the same machine state.
+//
+//	<policies> is a comma separated list of <A>/<R> pairs, a
+//	scheduling algorithm (-A) and a page replacement algorithm (-R),
+//	where "-" keeps the one in use; "*" stands for every pair.  E.g.
+//	"1/2,1/3,3/-".
+//
+//	The host copies the children's memory on write, so a branch costs
+//	next to nothing.  Each child writes its output to branch<n>.out,
+//	and its statistics back to the parent, which prints them in one
+//	table once all children are done, and exits.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef BRANCH_H
+#define BRANCH_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define MaxBranches	32		// policies in one branch
+
+extern bool BranchIsDue();		// Has the simulation reached
+					// the point set with -branch?
+extern void Branch();			// Fork a child per policy; only
+					// returns in the children
+
+#endif // BRANCH_H
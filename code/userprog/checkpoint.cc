@@ -0,0 +1,517 @@
+// checkpoint.cc
+//	Routines to save the whole simulation to a file, and to replace
+//	a freshly started simulation with a saved one.  See checkpoint.h.
+//
+//	A restore runs in the main thread of the new simulation, after
+//	Initialize.  It brings back every saved thread with a new kernel
+//	stack that starts it at its user registers, puts the threads
+//	back on the run and sleep queues, and then switches to the one
+//	that was running; the main thread is thrown away.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "checkpoint.h"
+#include "filetable.h"
+
+//----------------------------------------------------------------------
+// CheckpointFile::CheckpointFile
+// 	Open a checkpoint file.  Check IsOpen to see if it worked.
+//
+//	"fileName" -- the host file
+//	"writing" -- TRUE to create it, FALSE to read it
+//----------------------------------------------------------------------
+
+CheckpointFile::CheckpointFile(char *fileName, bool writing)
+{
+    fp = fopen(fileName, writing ? "wb" : "rb");
+    ioBuffer = NULL;
+    if (fp != NULL) {
+	ioBuffer = new char[CheckpointBufferSize];
+	setvbuf(fp, ioBuffer, _IOFBF, CheckpointBufferSize);
+    }
+}
+
+//----------------------------------------------------------------------
+// CheckpointFile::~CheckpointFile
+// 	Flush and close the file.
+//----------------------------------------------------------------------
+
+CheckpointFile::~CheckpointFile()
+{
+    if (fp != NULL)
+	fclose(fp);
+    delete [] ioBuffer;
+}
+
+//----------------------------------------------------------------------
+// CheckpointFile::Write, CheckpointFile::Read
+// 	Copy "numBytes" bytes to or from the file.
+//----------------------------------------------------------------------
+
+void
+CheckpointFile::Write(void *from, int numBytes)
+{
+    size_t done = fwrite(from, 1, numBytes, fp);
+
+    ASSERT(done == (size_t) numBytes);
+}
+
+void
+CheckpointFile::Read(void *into, int numBytes)
+{
+    size_t done = fread(into, 1, numBytes, fp);
+
+    ASSERT(done == (size_t) numBytes);
+}
+
+void
+CheckpointFile::WriteInt(int value)
+{
+    Write(&value, sizeof(int));
+}
+
+int
+CheckpointFile::ReadInt()
+{
+    int value;
+
+    Read(&value, sizeof(int));
+    return value;
+}
+
+//----------------------------------------------------------------------
+// CheckpointFile::WriteString, CheckpointFile::ReadString
+// 	Save a string with its length; read it back into a new array.
+//----------------------------------------------------------------------
+
+void
+CheckpointFile::WriteString(char *s)
+{
+    int length = strlen(s);
+
+    WriteInt(length);
+    Write(s, length);
+}
+
+char *
+CheckpointFile::ReadString()
+{
+    int length = ReadInt();
+    char *s;
+
+    ASSERT(length >= 0);
+    s = new char[length + 1];
+    Read(s, length);
+    s[length] = '\0';
+    return s;
+}
+
+//----------------------------------------------------------------------
+// CheckpointFile::WriteMemory
+// 	Save a memory image, one chunk of CheckpointChunkSize bytes at a
+//	time.  Each chunk is preceded by a flag; a chunk of zeros is
+//	only the flag.  Most of a large physical memory and of the swap
+//	areas is untouched, so this keeps checkpoints small.
+//----------------------------------------------------------------------
+
+void
+CheckpointFile::WriteMemory(char *from, int numBytes)
+{
+    int offset, size, i;
+    char nonZero;
+
+    for (offset = 0; offset < numBytes; offset += CheckpointChunkSize) {
+	size = min(CheckpointChunkSize, numBytes - offset);
+	for (i = 0; (i < size) && (from[offset + i] == 0); i++)
+	    ;
+	nonZero = (i < size);
+	Write(&nonZero, 1);
+	if (nonZero)
+	    Write(from + offset, size);
+    }
+}
+
+//----------------------------------------------------------------------
+// CheckpointFile::ReadMemory
+// 	Read back an image saved by WriteMemory.
+//----------------------------------------------------------------------
+
+void
+CheckpointFile::ReadMemory(char *into, int numBytes)
+{
+    int offset, size;
+    char nonZero;
+
+    for (offset = 0; offset < numBytes; offset += CheckpointChunkSize) {
+	size = min(CheckpointChunkSize, numBytes - offset);
+	Read(&nonZero, 1);
+	if (nonZero)
+	    Read(into + offset, size);
+	else
+	    memset(into + offset, 0, size);
+    }
+}
+
+//----------------------------------------------------------------------
+// IsLive
+// 	Is "pid" a thread that has not exited?
+//----------------------------------------------------------------------
+
+static bool
+IsLive(int pid)
+{
+    return ((threadArray[pid] != NULL) && !exitThreadArray[pid]);
+}
+
+//----------------------------------------------------------------------
+// CheckpointIsSafe
+// 	Can the simulation be checkpointed now?  Called on entry to a
+//	system call.  Every thread must be a user program that can be
+//	restarted from its user registers, and no device but the timer
+//	and the keyboard poll may have an interrupt pending.  User
+//	semaphores and condition variables are not saved, so there must
+//	be none; nor may any process have a file open but the console.
+//	Each thread's address space is saved on its own, so no thread
+//	may run in an address space made by another (ThreadCreate).
+//----------------------------------------------------------------------
+
+bool
+CheckpointIsSafe()
+{
+    unsigned pid;
+
+    if ((currentThread->space == NULL) || !userSemaphores->IsEmpty() ||
+					!userConditions->IsEmpty())
+	return FALSE;
+    for (pid = 0; pid < thread_index; pid++) {
+	if (!IsLive(pid))
+	    continue;
+	if ((threadArray[pid]->space == NULL) ||
+			(threadArray[pid]->space->pid != (int) pid) ||
+			!threadArray[pid]->space->files->OnlyConsole())
+	    return FALSE;
+	if ((threadArray[pid] != currentThread) &&
+					!threadArray[pid]->IsResumable())
+	    return FALSE;
+    }
+    return ((interrupt->PendingTime(DiskInt) == -1) &&
+	    (interrupt->PendingTime(ConsoleWriteInt) == -1) &&
+	    (interrupt->PendingTime(NetworkSendInt) == -1) &&
+	    (interrupt->PendingTime(NetworkRecvInt) == -1));
+}
+
+//----------------------------------------------------------------------
+// TakeCheckpoint
+// 	Save the simulation to "fileName".  Must only be called when
+//	CheckpointIsSafe, at the start of a system call.  Takes no
+//	simulated time.
+//----------------------------------------------------------------------
+
+void
+TakeCheckpoint(char *fileName)
+{
+    CheckpointFile *file = new CheckpointFile(fileName, TRUE);
+    TimeSortedWaitQueue *sleeper;
+    int type, numLive, numSleeping, i;
+    unsigned pid;
+    int *frame;
+
+    if (!file->IsOpen()) {
+	printf("Unable to create checkpoint file %s\n", fileName);
+	delete file;
+	return;
+    }
+    printf("[%d] Checkpoint to %s\n", stats->totalTicks, fileName);
+
+    numLive = 0;
+    for (pid = 0; pid < thread_index; pid++) {
+	if (IsLive(pid)) {
+#ifdef USE_TLB
+	    tlbManager->WriteBack(pid, FALSE);	// use and dirty bits
+#endif
+	    numLive++;
+	}
+    }
+
+    file->WriteInt(CheckpointMagic);
+    file->WriteInt(CheckpointVersion);
+    file->WriteInt(NumTotalRegs);	// sizes of the raw register
+    file->WriteInt(sizeof(Statistics));	// and statistics blocks
+    file->WriteInt(PageSize);
+    file->WriteInt(NumPhysPages);
+    file->WriteInt(numCPUs);
+
+    file->WriteInt(schedulingAlgo);
+    file->WriteInt(replacementAlgo);
+    file->WriteInt(pageTableType);
+    file->WriteInt(useLargePages);
+    file->WriteInt(numPagesAllocated);
+    file->WriteInt(usedPages);
+    file->WriteInt(LRU_Clock_ptr);
+    file->WriteInt(cpu_burst_start_time);
+    file->WriteInt(currentCPU);
+    file->WriteInt(thread_index);
+    file->WriteInt(excludeMainThread);
+    file->WriteInt(RandomState());
+    file->Write(exitThreadArray, thread_index * sizeof(bool));
+    file->Write(completionTimeArray, thread_index * sizeof(int));
+    file->Write(stats, sizeof(Statistics));
+    for (type = TimerInt; type <= NetworkRecvInt; type++)
+	file->WriteInt(interrupt->PendingTime((IntType) type));
+
+    file->WriteMemory(machine->mainMemory, MemorySize);
+    file->Write(machine->memoryUsedBy, NumPhysPages * sizeof(int));
+    file->Write(machine->virtualPageNo, NumPhysPages * sizeof(int));
+    file->Write(machine->referenceBit, NumPhysPages * sizeof(bool));
+    file->Write(machine->isShared, NumPhysPages * sizeof(bool));
+    file->Write(machine->isLocked, NumPhysPages * sizeof(bool));
+    file->WriteInt(machine->numLockedPages);
+    file->Write(machine->LRUTimeStamp, NumPhysPages * sizeof(long long int));
+
+    file->WriteInt(FIFOQueue->Length());
+    for (i = FIFOQueue->Length(); i > 0; i--) {	// rotate it once
+	frame = (int *)FIFOQueue->Remove();
+	file->WriteInt(*frame);
+	FIFOQueue->Append((void *)frame);
+    }
+
+    file->WriteInt(numLive);
+    for (pid = 0; pid < thread_index; pid++) {
+	if (IsLive(pid)) {
+	    file->WriteInt(pid);
+	    file->WriteString(threadArray[pid]->getName());
+	    threadArray[pid]->Checkpoint(file);
+	}
+    }
+    file->WriteInt(currentThread->GetPID());
+    scheduler->Checkpoint(file);
+
+    numSleeping = 0;
+    for (sleeper = sleepQueueHead; sleeper != NULL; sleeper = sleeper->GetNext())
+	numSleeping++;
+    file->WriteInt(numSleeping);
+    for (sleeper = sleepQueueHead; sleeper != NULL; sleeper = sleeper->GetNext()) {
+	file->WriteInt(sleeper->GetThread()->GetPID());
+	file->WriteInt(sleeper->GetWhen());
+    }
+    file->WriteInt(CheckpointMagic);
+    delete file;
+}
+
+//----------------------------------------------------------------------
+// ResumeFromCheckpoint
+// 	Where a restored thread starts: finish the context switch, and
+//	carry on with its user program.
+//----------------------------------------------------------------------
+
+static void
+ResumeFromCheckpoint(int dummy)
+{
+    currentThread->Startup();
+    machine->Run();
+}
+
+//----------------------------------------------------------------------
+// ChangePolicies
+// 	Carry on the running simulation with another scheduling
+//	algorithm and page replacement algorithm.  Bring the state the
+//	new ones rely on into a form they can start from.
+//----------------------------------------------------------------------
+
+void
+ChangePolicies(int newSchedulingAlgo, int newReplacementAlgo)
+{
+    int oldSchedulingAlgo = schedulingAlgo;
+    int oldReplacementAlgo = replacementAlgo;
+    unsigned pid;
+    int i, highest, *frame;
+
+    schedulingAlgo = newSchedulingAlgo;
+    replacementAlgo = newReplacementAlgo;
+    if (schedulingAlgo != oldSchedulingAlgo) {
+	// Priorities and burst estimates mean different things to
+	// each algorithm; start them over
+	for (pid = 0; pid < thread_index; pid++) {
+	    if (!IsLive(pid))
+		continue;
+	    threadArray[pid]->SetUsage(0);
+	    if (schedulingAlgo == NON_PREEMPTIVE_SJF)
+		threadArray[pid]->SetPriority(INITIAL_TAU);
+	    else
+		threadArray[pid]->SetPriority(threadArray[pid]->GetBasePriority());
+	}
+    }
+
+    if (replacementAlgo == oldReplacementAlgo)
+	return;
+    if ((replacementAlgo == FIFO_REPL) && FIFOQueue->IsEmpty()) {
+	// Queue the frames in use; their load order is not known
+	for (i = 0; i < NumPhysPages; i++) {
+	    if ((machine->memoryUsedBy[i] != -1) && !machine->isShared[i]) {
+		frame = new int;
+		*frame = i;
+		FIFOQueue->Append((void *)frame);
+	    }
+	}
+    }
+    if (replacementAlgo == NO_REPL) {
+	// Frames are handed out in order from numPagesAllocated
+	highest = -1;
+	for (i = 0; i < NumPhysPages; i++) {
+	    if (machine->memoryUsedBy[i] != -1)
+		highest = i;
+	}
+	if ((int) numPagesAllocated < highest + 1)
+	    numPagesAllocated = highest + 1;
+    }
+}
+
+//----------------------------------------------------------------------
+// RestoreCheckpoint
+// 	Replace the simulation that has just started with the one saved
+//	in "fileName", and run it.  Called in the main thread, before
+//	any user program has started.  Returns only if the checkpoint
+//	cannot be used.
+//
+//	"keepSchedulingAlgo" -- the scheduling algorithm was set on the
+//		command line; run on with it rather than the saved one
+//	"keepReplacementAlgo" -- likewise for page replacement
+//----------------------------------------------------------------------
+
+void
+RestoreCheckpoint(char *fileName, bool keepSchedulingAlgo,
+		  bool keepReplacementAlgo)
+{
+    CheckpointFile *file = new CheckpointFile(fileName, FALSE);
+    NachOSThread *self = currentThread, *thread;
+    TimeSortedWaitQueue *sleeper, *last;
+    int newSchedulingAlgo = schedulingAlgo;	// from the command line
+    int newReplacementAlgo = replacementAlgo;
+    int savedThreadIndex;
+    int type, when, numLive, numSleeping, currentPid, i, *frame;
+    unsigned pid;
+    char *name;
+
+    if (!file->IsOpen()) {
+	printf("Unable to open checkpoint file %s\n", fileName);
+	delete file;
+	return;
+    }
+    if ((file->ReadInt() != CheckpointMagic) ||
+				(file->ReadInt() != CheckpointVersion)) {
+	printf("%s is not a checkpoint\n", fileName);
+	delete file;
+	return;
+    }
+    if ((file->ReadInt() != NumTotalRegs) ||
+				(file->ReadInt() != (int) sizeof(Statistics))) {
+	printf("Checkpoint %s was taken by another build of Nachos\n",
+	       fileName);
+	delete file;
+	return;
+    }
+    if ((file->ReadInt() != (int) PageSize) ||
+	(file->ReadInt() != (int) NumPhysPages) ||
+	(file->ReadInt() != numCPUs)) {
+	printf("Checkpoint %s was taken with another machine: use the same "
+	       "-ps and -cpus flags\n", fileName);
+	delete file;
+	return;
+    }
+
+    (void) interrupt->SetLevel(IntOff);
+
+    schedulingAlgo = file->ReadInt();
+    replacementAlgo = file->ReadInt();
+    pageTableType = file->ReadInt();
+    useLargePages = file->ReadInt();
+    numPagesAllocated = file->ReadInt();
+    usedPages = file->ReadInt();
+    LRU_Clock_ptr = file->ReadInt();
+    cpu_burst_start_time = file->ReadInt();
+    currentCPU = file->ReadInt();
+    savedThreadIndex = file->ReadInt();
+    ASSERT(savedThreadIndex < MAX_THREAD_COUNT);
+    excludeMainThread = file->ReadInt();
+    RandomInit(file->ReadInt());
+    file->Read(exitThreadArray, savedThreadIndex * sizeof(bool));
+    file->Read(completionTimeArray, savedThreadIndex * sizeof(int));
+
+    // The first restored thread to run enables interrupts, which
+    // charges a SystemTick the saved simulation never saw
+    file->Read(stats, sizeof(Statistics));
+    stats->totalTicks -= SystemTick;
+    stats->systemTicks -= SystemTick;
+
+    // Devices of this simulation that were quiet in the saved one
+    // keep their interrupts; they only poll
+    for (type = TimerInt; type <= NetworkRecvInt; type++) {
+	when = file->ReadInt();
+	if (when != -1)
+	    interrupt->Reschedule((IntType) type, when);
+    }
+
+    file->ReadMemory(machine->mainMemory, MemorySize);
+    file->Read(machine->memoryUsedBy, NumPhysPages * sizeof(int));
+    file->Read(machine->virtualPageNo, NumPhysPages * sizeof(int));
+    file->Read(machine->referenceBit, NumPhysPages * sizeof(bool));
+    file->Read(machine->isShared, NumPhysPages * sizeof(bool));
+    file->Read(machine->isLocked, NumPhysPages * sizeof(bool));
+    machine->numLockedPages = file->ReadInt();
+    file->Read(machine->LRUTimeStamp, NumPhysPages * sizeof(long long int));
+
+    for (i = file->ReadInt(); i > 0; i--) {
+	frame = new int;
+	*frame = file->ReadInt();
+	FIFOQueue->Append((void *)frame);
+    }
+
+    // Bring the threads back under their old pids.  With no current
+    // thread, the constructor does not make them children of main.
+    currentThread = NULL;
+    for (pid = 0; pid < (unsigned) savedThreadIndex; pid++)
+	threadArray[pid] = NULL;
+    numLive = file->ReadInt();
+    for (i = 0; i < numLive; i++) {
+	thread_index = file->ReadInt();
+	name = file->ReadString();
+	thread = new NachOSThread(name, 0);
+	delete [] name;
+	thread->Restore(file, ResumeFromCheckpoint);
+    }
+    currentThread = self;
+    thread_index = savedThreadIndex;
+    stats->numTotalThreads = thread_index;
+    currentPid = file->ReadInt();
+    ASSERT(IsLive(currentPid));
+    scheduler->Restore(file);
+
+    last = NULL;
+    for (numSleeping = file->ReadInt(); numSleeping > 0; numSleeping--) {
+	pid = file->ReadInt();
+	ASSERT(IsLive(pid));
+	sleeper = new TimeSortedWaitQueue(threadArray[pid], file->ReadInt());
+	if (last == NULL)
+	    sleepQueueHead = sleeper;
+	else
+	    last->SetNext(sleeper);
+	last = sleeper;
+    }
+    i = file->ReadInt();
+    ASSERT(i == CheckpointMagic);
+    delete file;
+
+    ChangePolicies(keepSchedulingAlgo ? newSchedulingAlgo : schedulingAlgo,
+		   keepReplacementAlgo ? newReplacementAlgo : replacementAlgo);
+    printf("[%d] Restored from %s\n", stats->totalTicks + SystemTick, fileName);
+
+    // Switch to the thread that was running, and never come back
+    threadToBeDestroyed = self;
+    self->setStatus(BLOCKED);
+    scheduler->Schedule(threadArray[currentPid]);
+    ASSERT(FALSE);
+}
@@ -0,0 +1,87 @@
+// checkpoint.h
+//	Data structures to save a running simulation to a file, and to
+//	resume it later from that file.
+//
+//	  nachos ... -ckpt <tick> <file>	save the simulation once
+//	  nachos [-A n] [-R n] -restore <file>	carry on from a checkpoint
+//
+//	A checkpoint holds main memory and what the kernel knows about
+//	every frame, the page tables and swap areas of every address
+//	space, every live thread's user registers and scheduling state,
+//	the run queues, the sleep queue, when the devices will next
+//	interrupt, the random number generator and the statistics.
+//
+//	Kernel stacks are host memory and cannot be saved, so a
+//	checkpoint is only taken when every thread can be restarted
+//	from its user registers: the running thread has just trapped
+//	into a system call (it issues the call again when restored),
+//	and every other thread is either in user mode, or asleep at a
+//	point the kernel marked with SetResumable (page fault wait,
+//	Sleep, Join, Yield).  No device other than the timer (and the
+//	keyboard poll) may have an interrupt in flight.  The checkpoint
+//	is taken at the first system call at or after <tick> where all
+//	of this holds.
+//
+//	The caches and branch predictor are not saved; they start out
+//	cold after a restore.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define CheckpointMagic		0x4e4b5054	// start and end of a file
+#define CheckpointVersion	4		// raised when the layout changes
+#define CheckpointBufferSize	(1024 * 1024)	// host I/O buffer
+#define CheckpointChunkSize	1024		// memory is saved in chunks
+						// of this many bytes, and
+						// chunks of zeros are skipped
+
+// A checkpoint file, open for writing or for reading.  Short reads
+// and writes are fatal.
+
+class CheckpointFile {
+  public:
+    CheckpointFile(char *fileName, bool writing);
+    ~CheckpointFile();
+
+    bool IsOpen() { return (fp != NULL); }
+
+    void Write(void *from, int numBytes);
+    void Read(void *into, int numBytes);
+    void WriteInt(int value);
+    int ReadInt();
+    void WriteString(char *s);
+    char *ReadString();			// allocated with new
+
+    void WriteMemory(char *from, int numBytes);
+					// Write a memory image, leaving
+					// out chunks that are all zero
+    void ReadMemory(char *into, int numBytes);
+
+  private:
+    FILE *fp;
+    char *ioBuffer;			// large buffer for fp
+};
+
+extern bool CheckpointIsSafe();		// Can every thread be restarted
+					// from its user registers?
+extern void TakeCheckpoint(char *fileName);
+extern void RestoreCheckpoint(char *fileName, bool keepSchedulingAlgo,
+			      bool keepReplacementAlgo);
+					// Replace this simulation with the
+					// saved one; does not return
+					// unless the file is unusable.
+					// The "keep" flags keep the
+					// policies set on the command line
+					// instead of the saved ones
+extern void ChangePolicies(int newSchedulingAlgo, int newReplacementAlgo);
+					// Switch the running simulation
+					// to other policies
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,142 @@
+// consoledriver.cc
+//	Routines of the kernel's console driver.  See consoledriver.h.
+//
+//	The ring counters only grow; a character's place in the ring is
+//	its number modulo ConsoleBufferSize.  They are changed with
+//	interrupts off, since WriteDone runs from the device interrupt.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "consoledriver.h"
+
+// Dummy functions because C++ is weird about pointers to member functions
+static void DriverReadAvail(int d)
+{ ConsoleDriver *driver = (ConsoleDriver *)d; driver->ReadAvail(); }
+static void DriverWriteDone(int d)
+{ ConsoleDriver *driver = (ConsoleDriver *)d; driver->WriteDone(); }
+
+//----------------------------------------------------------------------
+// ConsoleDriver::ConsoleDriver
+// 	Open the console device, with an empty output ring.
+//
+//	"readFile" -- UNIX file simulating the keyboard (NULL -> use stdin)
+//	"writeFile" -- UNIX file simulating the display (NULL -> use stdout)
+//----------------------------------------------------------------------
+
+ConsoleDriver::ConsoleDriver(char *readFile, char *writeFile)
+{
+    console = new Console(readFile, writeFile, DriverReadAvail,
+			  DriverWriteDone, (int)this);
+    charAvail = new Semaphore("console char avail", 0);
+    progress = new Semaphore("console progress", 0);
+    numWaiting = 0;
+    numQueued = numSent = numDone = 0;
+}
+
+ConsoleDriver::~ConsoleDriver()
+{
+    delete console;
+    delete charAvail;
+    delete progress;
+}
+
+//----------------------------------------------------------------------
+// ConsoleDriver::StartBatch
+// 	If the device is free, hand it every queued character up to the
+//	end of the ring.  Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+ConsoleDriver::StartBatch()
+{
+    int first, size;
+
+    if ((numSent != numDone) || (numQueued == numSent))
+	return;					// busy, or nothing to send
+    first = numSent % ConsoleBufferSize;
+    size = numQueued - numSent;
+    if (first + size > ConsoleBufferSize)
+	size = ConsoleBufferSize - first;	// the rest goes next time
+    numSent += size;
+    console->PutBuffer(&ring[first], size);
+}
+
+//----------------------------------------------------------------------
+// ConsoleDriver::WriteDone
+// 	Interrupt handler: the batch is out.  Start the next one, and
+//	let every waiting writer check whether its characters are done
+//	or there is room for more.
+//----------------------------------------------------------------------
+
+void
+ConsoleDriver::WriteDone()
+{
+    numDone = numSent;
+    StartBatch();
+    for (; numWaiting > 0; numWaiting--)
+	progress->V();
+}
+
+//----------------------------------------------------------------------
+// ConsoleDriver::Write
+// 	Copy "size" characters into the ring, waiting for room when it
+//	is full, and wait until the device has put out the last of them.
+//----------------------------------------------------------------------
+
+void
+ConsoleDriver::Write(char *buffer, int size)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int i = 0, last;
+
+    while (i < size) {
+	while (numQueued - numDone == ConsoleBufferSize) {
+	    StartBatch();
+	    numWaiting++;
+	    progress->P();			// for room
+	}
+	for (; (i < size) && (numQueued - numDone < ConsoleBufferSize); i++)
+	    ring[numQueued++ % ConsoleBufferSize] = buffer[i];
+    }
+    last = numQueued;
+    StartBatch();
+    while (numDone < last) {
+	numWaiting++;
+	progress->P();				// for our characters
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// ConsoleDriver::GetChar
+// 	Wait for a character to be typed, and return it.
+//----------------------------------------------------------------------
+
+char
+ConsoleDriver::GetChar()
+{
+    charAvail->P();
+    return console->GetChar();
+}
+
+//----------------------------------------------------------------------
+// ConsoleDriver::Read
+// 	Wait for a character to be typed, and return it in "buffer"
+//	with any others that have come in since, up to "size" of them.
+//	Returns how many there are.
+//----------------------------------------------------------------------
+
+int
+ConsoleDriver::Read(char *buffer, int size)
+{
+    int numRead = 0;
+
+    do {
+	buffer[numRead++] = GetChar();
+    } while ((numRead < size) && (charAvail->getValue() > 0));
+    return numRead;
+}
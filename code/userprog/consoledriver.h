@@ -0,0 +1,65 @@
+// consoledriver.h
+//	Data structures for the kernel's console driver: the one owner of
+//	the console device, created at boot, through which the system
+//	calls read the keyboard and write the display.
+//
+//	Output is copied into a ring buffer.  Whenever the display is
+//	free, everything waiting in the ring (up to its wrap-around
+//	point) goes out as one batch: one host write, and one completion
+//	interrupt for the whole batch.  Characters that other threads
+//	write while a batch is out are sent together in the next one.
+//
+//	Write returns once its characters have gone out, so output from
+//	one thread stays in order with whatever the kernel prints after
+//	it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CONSOLEDRIVER_H
+#define CONSOLEDRIVER_H
+
+#include "copyright.h"
+#include "console.h"
+#include "synch.h"
+
+#define ConsoleBufferSize	256	// characters in the output ring
+
+class ConsoleDriver {
+  public:
+    ConsoleDriver(char *readFile, char *writeFile);
+					// Open the console device
+    ~ConsoleDriver();			// Close it
+
+    void PutChar(char ch) { Write(&ch, 1); }
+    void Write(char *buffer, int size);	// Send "size" characters to
+					// the display; returns once
+					// they are out
+    char GetChar();			// Wait for a character from
+					// the keyboard
+    int Read(char *buffer, int size);	// Wait for one character, then
+					// take up to "size" of those
+					// already typed
+
+// internal routines, called from the device interrupts
+    void WriteDone();
+    void ReadAvail() { charAvail->V(); }
+
+  private:
+    void StartBatch();			// Hand the device what is in
+					// the ring, if it is free
+
+    Console *console;			// the device
+    Semaphore *charAvail;		// a character was typed
+    Semaphore *progress;		// a batch went out
+    int numWaiting;			// threads waiting on progress
+
+    char ring[ConsoleBufferSize];	// characters numDone up to
+    int numQueued;			// numQueued, at their number
+    int numSent;			// modulo ConsoleBufferSize;
+    int numDone;			// those below numSent are with
+					// the device
+};
+
+#endif // CONSOLEDRIVER_H
@@ -4,8 +4,7 @@
 //	transfer back to here from user code:
 //
 //	syscall -- The user code explicitly requests to call a procedure
-//	in the Nachos kernel.  Right now, the only function we support is
-//	"Halt".
+//	in the Nachos kernel.
 //
 //	exceptions -- The user code does something that the CPU can't handle.
 //	For instance, accessing memory that doesn't exist, arithmetic errors,
@@ -14,8 +13,13 @@
 //	Interrupts (which can also cause control to transfer from user
 //	code into the Nachos kernel) are handled elsewhere.
 //
-// For now, this only handles the Halt() system call.
-// Everything else core dumps.
+//	System calls are dispatched through syscallTable, indexed by the
+//	system call code.  Each entry says when the program counters are
+//	to be advanced, so the handlers themselves only do the work; the
+//	handler also times each call, for Statistics::Print.
+//
+//	Page faults are handed to the address space.  Everything else
+//	core dumps.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -24,37 +28,13 @@
 #include "copyright.h"
 #include "system.h"
 #include "syscall.h"
-#include "console.h"
 #include "synch.h"
+#include "checkpoint.h"
+#include "branch.h"
+#include "usermem.h"
+#include "filetable.h"
 
-//----------------------------------------------------------------------
-// ExceptionHandler
-// 	Entry point into the Nachos kernel.  Called when a user program
-//	is executing, and either does a syscall, or generates an addressing
-//	or arithmetic exception.
-//
-// 	For system calls, the following is the calling convention:
-//
-// 	system call code -- r2
-//		arg1 -- r4
-//		arg2 -- r5
-//		arg3 -- r6
-//		arg4 -- r7
-//
-//	The result of the system call, if any, must be put back into r2.
-//
-// And don't forget to increment the pc before returning. (Or else you'll
-// loop making the same system call forever!
-//
-//	"which" is the kind of exception.  The list of possible exceptions
-//	are in machine.h.
-//----------------------------------------------------------------------
-static Semaphore *readAvail;
-static Semaphore *writeDone;
-static void ReadAvail(int arg) { readAvail->V(); }
-static void WriteDone(int arg) { writeDone->V(); }
-
-extern void StartUserProcess (char*);
+extern bool ExecUserProcess (char*, int, char**);
 
 void
 ForkStartFunction (int dummy)
@@ -63,259 +43,730 @@ ForkStartFunction (int dummy)
    machine->Run();
 }
 
-static void ConvertIntToHex (unsigned v, Console *console)
+// What a child made by system_call_Spawn is to be called with
+struct SpawnArgs {
+    int argc;
+    char *argv[MaxUserArgs];
+};
+
+// The first code run by a spawned child: start its program, with the
+// arguments "arg" (a SpawnArgs) points to.  Until now the child had no
+// user registers to be restarted from.
+static void
+SpawnStartFunction (int arg)
+{
+   SpawnArgs *args = (SpawnArgs *) arg;
+
+   currentThread->Startup();
+   currentThread->space->InitUserCPURegisters();
+   currentThread->space->PushArguments(args->argc, args->argv);
+   DeleteArgs(args->argv, args->argc);
+   delete args;
+   currentThread->SetResumable(TRUE);
+   machine->Run();
+}
+
+// What a thread made by system_call_ThreadCreate is to run
+struct ThreadArgs {
+    int func;				// user function, and the
+    int arg;				// argument it is called with
+    int returnAddr;			// where it returns to: a stub
+					// that calls system_call_Exit
+};
+
+// The first code run by a thread made by system_call_ThreadCreate:
+// call the function "arg" (a ThreadArgs) names, on the thread's own
+// user stack.
+static void
+ThreadStartFunction (int arg)
 {
-   unsigned x;
-   if (v == 0) return;
-   ConvertIntToHex (v/16, console);
-   x = v % 16;
-   if (x < 10) {
-      writeDone->P() ;
-      console->PutChar('0'+x);
+   ThreadArgs *args = (ThreadArgs *) arg;
+   int i;
+
+   currentThread->Startup();
+   for (i = 0; i < NumTotalRegs; i++)
+      machine->WriteRegister(i, 0);
+   machine->WriteRegister(PCReg, args->func);
+   machine->WriteRegister(NextPCReg, args->func + 4);
+   machine->WriteRegister(4, args->arg);
+   machine->WriteRegister(RetAddrReg, args->returnAddr);
+   machine->WriteRegister(StackReg, currentThread->userStack - 16);
+   delete args;
+   currentThread->SetResumable(TRUE);
+   machine->Run();
+}
+
+// Marks the current process as exited and terminates it, ending the
+// simulation if it was the last one.  Does not return.
+static void ExitCurrentProcess (int exitcode)
+{
+   unsigned i;
+
+   // We do not wait for the children to finish.
+   // The children will continue to run.
+   // We will worry about this when and if we implement signals.
+   exitThreadArray[currentThread->GetPID()] = true;
+   if (currentThread->userStack != -1)
+      currentThread->space->FreeUserStack(currentThread->userStack);
+   if (currentThread->space->DetachThread() == 0) {
+      delete currentThread->space->files;	// close every open file
+      currentThread->space->files = NULL;
    }
-   else {
-      writeDone->P() ;
-      console->PutChar('a'+x-10);
+
+   // Find out if all threads have called exit
+   for (i=0; i<thread_index; i++) {
+      if (!exitThreadArray[i]) break;
    }
+   currentThread->Exit(i==thread_index, exitcode);
 }
 
-void
-ExceptionHandler(ExceptionType which)
+//----------------------------------------------------------------------
+// AdvancePC
+// 	Step the program counters past the system call instruction, so
+//	that the user program carries on after it.
+//----------------------------------------------------------------------
+
+static void
+AdvancePC()
 {
-    int type = machine->ReadRegister(2);
-    int memval, vaddr, printval, tempval, exp;
-    unsigned printvalus;	// Used for printing in hex
-    if (!initializedConsoleSemaphores) {
-        readAvail = new Semaphore("read avail", 0);
-        writeDone = new Semaphore("write done", 1);
-        initializedConsoleSemaphores = true;
-    }
-    Console *console = new Console(NULL, NULL, ReadAvail, WriteDone, 0);
-    int exitcode;		// Used in SYScall_Exit
-    unsigned i;
-    char buffer[1024];		// Used in SYScall_Exec
-    int waitpid;		// Used in SYScall_Join
-    int whichChild;		// Used in SYScall_Join
-    NachOSThread *child;		// Used by SYScall_Fork
-    unsigned sleeptime;		// Used by SYScall_Sleep
-    unsigned virtAddr;          // Used by PageFaultException
+    machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
+    machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
+    machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+}
+
+//----------------------------------------------------------------------
+// CopyProgramArgs
+// 	Copy in the argv of Exec or Spawn, at "virtAddr", into "args".
+//	A NULL argv stands for the program "name" alone.  Returns argc,
+//	or -1; see CopyArgsFromUser.
+//----------------------------------------------------------------------
 
-    if ((which == SyscallException) && (type == SYScall_Halt)) {
-        DEBUG('a', "Shutdown, initiated by user program.\n");
-        interrupt->Halt();
+static int
+CopyProgramArgs(int virtAddr, char *name, char **args)
+{
+    if (virtAddr == 0) {
+        args[0] = new char[strlen(name) + 1];
+        strcpy(args[0], name);
+        return 1;
     }
-    else if ((which == SyscallException) && (type == SYScall_Exit)) {
-        exitcode = machine->ReadRegister(4);
-        printf("[pid %d]: Exit called. Code: %d\n", currentThread->GetPID(), exitcode);
-        // We do not wait for the children to finish.
-        // The children will continue to run.
-        // We will worry about this when and if we implement signals.
-        exitThreadArray[currentThread->GetPID()] = true;
-
-        // Find out if all threads have called exit
-        for (i=0; i<thread_index; i++) {
-            if (!exitThreadArray[i]) break;
-        }
-        currentThread->Exit(i==thread_index, exitcode);
+    return CopyArgsFromUser(virtAddr, args, MaxUserArgs);
+}
+
+//----------------------------------------------------------------------
+// System call handlers
+// 	One per system call, with the arguments in r4-r7; the result,
+//	if any, goes back into r2.  The program counters are advanced by
+//	ExceptionHandler, as syscallTable says.
+//----------------------------------------------------------------------
+
+static void
+SyscallHalt()
+{
+    DEBUG('a', "Shutdown, initiated by user program.\n");
+    interrupt->Halt();
+}
+
+static void
+SyscallExit()
+{
+    int exitcode = machine->ReadRegister(4);
+
+    printf("[pid %d]: Exit called. Code: %d\n", currentThread->GetPID(), exitcode);
+    ExitCurrentProcess(exitcode);
+}
+
+static void
+SyscallExec()
+{
+    char name[MaxUserString];
+    char *args[MaxUserArgs];
+    int length = CopyStringFromUser(machine->ReadRegister(4), name,
+                                    MaxUserString);
+    int argc = -1;
+
+    if ((length != -1) && (length < MaxUserString))
+        argc = CopyProgramArgs(machine->ReadRegister(5), name, args);
+    // Other threads still run in the old address space
+    if ((argc != -1) && (currentThread->space->NumThreads() > 1)) {
+        DeleteArgs(args, argc);
+        argc = -1;
     }
-    else if ((which == SyscallException) && (type == SYScall_Exec)) {
-        // Copy the executable name into kernel space
-        vaddr = machine->ReadRegister(4);
-        while(!machine->ReadMem(vaddr, 1, &memval));
-        i = 0;
-        while ((*(char*)&memval) != '\0') {
-            buffer[i] = (*(char*)&memval);
-            i++;
-            vaddr++;
-            while(!machine->ReadMem(vaddr, 1, &memval));
-        }
-        buffer[i] = (*(char*)&memval);
-        StartUserProcess(buffer);
+    if (argc == -1) {
+        machine->WriteRegister(2, -1);
+        return;
     }
-    else if ((which == SyscallException) && (type == SYScall_Join)) {
-        waitpid = machine->ReadRegister(4);
-        // Check if this is my child. If not, return -1.
-        whichChild = currentThread->CheckIfChild (waitpid);
-        if (whichChild == -1) {
-            printf("[pid %d] Cannot join with non-existent child [pid %d].\n", currentThread->GetPID(), waitpid);
-            machine->WriteRegister(2, -1);
-            // Advance program counters.
-            machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-            machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-            machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-        }
-        else {
-            exitcode = currentThread->JoinWithChild (whichChild);
-            machine->WriteRegister(2, exitcode);
-            // Advance program counters.
-            machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-            machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-            machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-        }
+    // On success the registers are those of the new program, which
+    // starts when the handler returns
+    if (!ExecUserProcess(name, argc, args))
+        machine->WriteRegister(2, -1);
+    DeleteArgs(args, argc);
+}
+
+static void
+SyscallJoin()
+{
+    int waitpid = machine->ReadRegister(4);
+    int whichChild;
+
+    // Check if this is my child. If not, return -1.
+    whichChild = currentThread->CheckIfChild (waitpid);
+    if (whichChild == -1) {
+        printf("[pid %d] Cannot join with non-existent child [pid %d].\n", currentThread->GetPID(), waitpid);
+        machine->WriteRegister(2, -1);
     }
-    else if ((which == SyscallException) && (type == SYScall_Fork)) {
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-
-        child = new NachOSThread("Forked thread", GET_NICE_FROM_PARENT);
-        child->space = new ProcessAddrSpace (currentThread->space, child->GetPID());  // Duplicates the address space
-        child->space->CopyParentAddrSpace(currentThread->space);
-
-        child->SaveUserState ();		     		      // Duplicate the register set
-        child->ResetReturnValue ();			     // Sets the return register to zero
-        child->AllocateThreadStack (ForkStartFunction, 0);	// Make it ready for a later context switch
-        child->Schedule ();
-        machine->WriteRegister(2, child->GetPID());		// Return value for parent
+    else {
+        currentThread->SetResumable(TRUE);	// issues the Join again
+        machine->WriteRegister(2, currentThread->JoinWithChild (whichChild));
     }
-    else if ((which == SyscallException) && (type == SYScall_ShmAllocate)) {
-        int size = machine->ReadRegister(4);
-        int addr = currentThread->space->AddSharedSpace(size);
-        machine->WriteRegister(2, addr);
-
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+}
+
+static void
+SyscallCreate()
+{
+    char name[MaxUserString];
+    int length = CopyStringFromUser(machine->ReadRegister(4), name,
+                                    MaxUserString);
+
+    if ((length != -1) && (length < MaxUserString) &&
+                                        fileSystem->Create(name, 0))
+        machine->WriteRegister(2, 0);
+    else
+        machine->WriteRegister(2, -1);
+}
+
+static void
+SyscallOpen()
+{
+    char name[MaxUserString];
+    int length = CopyStringFromUser(machine->ReadRegister(4), name,
+                                    MaxUserString);
+    OpenFile *file = NULL;
+    int fd = -1;
+
+    if ((length != -1) && (length < MaxUserString))
+        file = fileSystem->Open(name);
+    if (file != NULL) {
+        fd = currentThread->space->files->Open(file);
+        if (fd == -1)
+            delete file;
     }
-    else if ((which == SyscallException) && (type == SYScall_Yield)) {
-        currentThread->YieldCPU();
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    machine->WriteRegister(2, fd);
+}
+
+static void
+SyscallRead()
+{
+    machine->WriteRegister(2, currentThread->space->files->Read(
+                machine->ReadRegister(6), machine->ReadRegister(4),
+                machine->ReadRegister(5)));
+}
+
+static void
+SyscallWrite()
+{
+    machine->WriteRegister(2, currentThread->space->files->Write(
+                machine->ReadRegister(6), machine->ReadRegister(4),
+                machine->ReadRegister(5)));
+}
+
+static void
+SyscallClose()
+{
+    machine->WriteRegister(2,
+            currentThread->space->files->Close(machine->ReadRegister(4)) ? 0 : -1);
+}
+
+static void
+SyscallFork()
+{
+    NachOSThread *child = new NachOSThread("Forked thread", GET_NICE_FROM_PARENT);
+
+    child->space = new ProcessAddrSpace (currentThread->space, child->GetPID());  // Duplicates the address space
+    child->space->CopyParentAddrSpace(currentThread->space);
+
+    child->SaveUserState ();		     		      // Duplicate the register set
+    child->ResetReturnValue ();			     // Sets the return register to zero
+    child->AllocateThreadStack (ForkStartFunction, 0);	// Make it ready for a later context switch
+    child->Schedule ();
+    machine->WriteRegister(2, child->GetPID());		// Return value for parent
+}
+
+// Fork and Exec in one: the child is loaded straight from the
+// executable, without a copy of the parent's address space being made
+// first.  It shares the parent's open files, as a forked child does.
+static void
+SyscallSpawn()
+{
+    char name[MaxUserString];
+    SpawnArgs *args = new SpawnArgs;
+    int length = CopyStringFromUser(machine->ReadRegister(4), name,
+                                    MaxUserString);
+    OpenFile *executable = NULL;
+    NachOSThread *child;
+
+    args->argc = -1;
+    if ((length != -1) && (length < MaxUserString))
+        args->argc = CopyProgramArgs(machine->ReadRegister(5), name, args->argv);
+    if (args->argc != -1) {
+        executable = fileSystem->Open(name);
+        if (executable == NULL)
+            DeleteArgs(args->argv, args->argc);
     }
-    else if ((which == SyscallException) && (type == SYScall_PrintInt)) {
-        printval = machine->ReadRegister(4);
-        if (printval == 0) {
-            writeDone->P() ;
-            console->PutChar('0');
-        }
-        else {
-            if (printval < 0) {
-                writeDone->P() ;
-                console->PutChar('-');
-                printval = -printval;
-            }
-            tempval = printval;
-            exp=1;
-            while (tempval != 0) {
-                tempval = tempval/10;
-                exp = exp*10;
-            }
-            exp = exp/10;
-            while (exp > 0) {
-                writeDone->P() ;
-                console->PutChar('0'+(printval/exp));
-                printval = printval % exp;
-                exp = exp/10;
-            }
-        }
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    if (executable == NULL) {
+        delete args;
+        machine->WriteRegister(2, -1);
+        return;
     }
-    else if ((which == SyscallException) && (type == SYScall_PrintChar)) {
-        writeDone->P() ;        // wait for previous write to finish
-        console->PutChar(machine->ReadRegister(4));   // echo it!
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+
+    child = new NachOSThread("Spawned thread", GET_NICE_FROM_PARENT);
+    child->space = new ProcessAddrSpace(executable, name, child->GetPID());
+    delete executable;
+    delete child->space->files;
+    child->space->files = new FileTable(currentThread->space->files);
+
+    child->SetResumable(FALSE);			// no user registers yet
+    child->AllocateThreadStack (SpawnStartFunction, (int) args);
+    child->Schedule ();
+    machine->WriteRegister(2, child->GetPID());
+}
+
+// A thread that runs func(arg) in this address space, on a stack of its
+// own; the page tables, frames and open files are shared, not copied.
+// It is a child of the caller, so Join waits for it.
+static void
+SyscallThreadCreate()
+{
+    ProcessAddrSpace *space = currentThread->space;
+    int stack = space->AllocateUserStack();
+    ThreadArgs *args;
+    NachOSThread *child;
+
+    if (stack == -1) {
+        machine->WriteRegister(2, -1);
+        return;
     }
-    else if ((which == SyscallException) && (type == SYScall_PrintString)) {
-        vaddr = machine->ReadRegister(4);
-        while(!machine->ReadMem(vaddr, 1, &memval));
-        while ((*(char*)&memval) != '\0') {
-            writeDone->P() ;
-            console->PutChar(*(char*)&memval);
-            vaddr++;
-            while(!machine->ReadMem(vaddr, 1, &memval));
-        }
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    args = new ThreadArgs;
+    args->func = machine->ReadRegister(4);
+    args->arg = machine->ReadRegister(5);
+    args->returnAddr = machine->ReadRegister(6);
+
+    child = new NachOSThread("User thread", GET_NICE_FROM_PARENT);
+    child->space = space;
+    child->userStack = stack;
+    space->AttachThread();
+
+    child->SetResumable(FALSE);			// no user registers yet
+    child->AllocateThreadStack (ThreadStartFunction, (int) args);
+    child->Schedule ();
+    machine->WriteRegister(2, child->GetPID());
+}
+
+static void
+SyscallShmAllocate()
+{
+    int size = machine->ReadRegister(4);
+
+    machine->WriteRegister(2, currentThread->space->AddSharedSpace(size));
+}
+
+static void
+SyscallSbrk()
+{
+    machine->WriteRegister(2, currentThread->space->GrowHeap(machine->ReadRegister(4)));
+}
+
+static void
+SyscallMadvise()
+{
+    machine->WriteRegister(2, currentThread->space->Advise(machine->ReadRegister(4),
+                                                           machine->ReadRegister(5),
+                                                           machine->ReadRegister(6)));
+}
+
+static void
+SyscallYield()
+{
+    currentThread->SetResumable(TRUE);
+    currentThread->YieldCPU();
+}
+
+static void
+SyscallPrintInt()
+{
+    char digits[16];
+
+    sprintf(digits, "%d", machine->ReadRegister(4));
+    consoleDriver->Write(digits, strlen(digits));
+}
+
+static void
+SyscallPrintChar()
+{
+    consoleDriver->PutChar(machine->ReadRegister(4));   // echo it!
+}
+
+static void
+SyscallPrintString()
+{
+    char buffer[ConsoleBufferSize];
+    int vaddr = machine->ReadRegister(4);
+    int size;
+
+    // Hand the string to the console a bufferful at a time
+    do {
+        size = CopyStringFromUser(vaddr, buffer, ConsoleBufferSize);
+        if (size > 0)
+            consoleDriver->Write(buffer, size);
+        vaddr += size;
+    } while (size == ConsoleBufferSize);
+}
+
+static void
+SyscallGetReg()
+{
+    machine->WriteRegister(2, machine->ReadRegister(machine->ReadRegister(4))); // Return value
+}
+
+static void
+SyscallGetPA()
+{
+    machine->WriteRegister(2, machine->GetPA(machine->ReadRegister(4)));  // Return value
+}
+
+static void
+SyscallGetPID()
+{
+    machine->WriteRegister(2, currentThread->GetPID());
+}
+
+static void
+SyscallGetPPID()
+{
+    machine->WriteRegister(2, currentThread->GetPPID());
+}
+
+static void
+SyscallSleep()
+{
+    unsigned sleeptime = machine->ReadRegister(4);
+
+    currentThread->SetResumable(TRUE);	// only the wait is left
+    if (sleeptime == 0) {
+        // emulate a yield
+        currentThread->YieldCPU();
     }
-    else if ((which == SyscallException) && (type == SYScall_GetReg)) {
-        machine->WriteRegister(2, machine->ReadRegister(machine->ReadRegister(4))); // Return value
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    else {
+        currentThread->SortedInsertInWaitQueue (sleeptime+stats->totalTicks);
     }
-    else if ((which == SyscallException) && (type == SYScall_GetPA)) {
-        vaddr = machine->ReadRegister(4);
-        machine->WriteRegister(2, machine->GetPA(vaddr));  // Return value
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+}
+
+static void
+SyscallTime()
+{
+    machine->WriteRegister(2, stats->totalTicks);
+}
+
+static void
+SyscallPrintIntHex()
+{
+    char digits[16];
+
+    sprintf(digits, "0x%x", (unsigned)machine->ReadRegister(4));
+    consoleDriver->Write(digits, strlen(digits));
+}
+
+static void
+SyscallSemGet()
+{
+    int key = machine->ReadRegister(4);
+    int id = userSemaphores->Find(key);
+
+    if (id == -1) {
+        Semaphore *sem = new Semaphore("user semaphore", 0);
+        id = userSemaphores->Add(key, sem);
+        if (id == -1)
+            delete sem;
     }
-    else if ((which == SyscallException) && (type == SYScall_GetPID)) {
-        machine->WriteRegister(2, currentThread->GetPID());
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    machine->WriteRegister(2, id);
+}
+
+static void
+SyscallSemOp()
+{
+    Semaphore *sem = (Semaphore *)userSemaphores->Lookup(machine->ReadRegister(4));
+    int adjust = machine->ReadRegister(5);
+
+    if ((sem != NULL) && (adjust < 0))
+        sem->P();
+    else if ((sem != NULL) && (adjust > 0))
+        sem->V();
+}
+
+static void
+SyscallSemCtl()
+{
+    int id = machine->ReadRegister(4);
+    Semaphore *sem = (Semaphore *)userSemaphores->Lookup(id);
+    int vaddr = machine->ReadRegister(6);
+    int word, result = -1;
+
+    if (sem == NULL)
+        ;
+    else if (machine->ReadRegister(5) == SYNCH_REMOVE) {
+        if (!sem->hasWaiters()) {
+            userSemaphores->Remove(id);
+            delete sem;
+            result = 0;
+        }
     }
-    else if ((which == SyscallException) && (type == SYScall_GetPPID)) {
-        machine->WriteRegister(2, currentThread->GetPPID());
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    else if (machine->ReadRegister(5) == SYNCH_GET) {
+        word = WordToMachine(sem->getValue());
+        if (CopyToUser(vaddr, (char *)&word, 4))
+            result = 0;
     }
-    else if ((which == SyscallException) && (type == SYScall_Sleep)) {
-        sleeptime = machine->ReadRegister(4);
-        if (sleeptime == 0) {
-            // emulate a yield
-            currentThread->YieldCPU();
+    else if (machine->ReadRegister(5) == SYNCH_SET) {
+        if (CopyFromUser(vaddr, (char *)&word, 4) &&
+                                        ((int)WordToHost(word) >= 0)) {
+            sem->setValue(WordToHost(word));
+            result = 0;
         }
-        else {
-            currentThread->SortedInsertInWaitQueue (sleeptime+stats->totalTicks);
-        }
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
     }
-    else if ((which == SyscallException) && (type == SYScall_Time)) {
-        machine->WriteRegister(2, stats->totalTicks);
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    machine->WriteRegister(2, result);
+}
+
+static void
+SyscallCondGet()
+{
+    int key = machine->ReadRegister(4);
+    int id = userConditions->Find(key);
+
+    if (id == -1) {
+        UserCondition *cond = new UserCondition("user condition");
+        id = userConditions->Add(key, cond);
+        if (id == -1)
+            delete cond;
+    }
+    machine->WriteRegister(2, id);
+}
+
+static void
+SyscallCondOp()
+{
+    UserCondition *cond = (UserCondition *)userConditions->Lookup(machine->ReadRegister(4));
+    Semaphore *mutex = (Semaphore *)userSemaphores->Lookup(machine->ReadRegister(6));
+    int op = machine->ReadRegister(5);
+
+    if (cond == NULL)
+        ;
+    else if ((op == COND_OP_WAIT) && (mutex != NULL))
+        cond->Wait(mutex);
+    else if (op == COND_OP_SIGNAL)
+        cond->Signal();
+    else if (op == COND_OP_BROADCAST)
+        cond->Broadcast();
+}
+
+static void
+SyscallCondRemove()
+{
+    int id = machine->ReadRegister(4);
+    UserCondition *cond = (UserCondition *)userConditions->Lookup(id);
+    int result = -1;
+
+    if ((cond != NULL) && !cond->hasWaiters()) {
+        userConditions->Remove(id);
+        delete cond;
+        result = 0;
     }
-    else if ((which == SyscallException) && (type == SYScall_PrintIntHex)) {
-        printvalus = (unsigned)machine->ReadRegister(4);
-        writeDone->P() ;
-        console->PutChar('0');
-        writeDone->P() ;
-        console->PutChar('x');
-        if (printvalus == 0) {
-            writeDone->P() ;
-            console->PutChar('0');
+    machine->WriteRegister(2, result);
+}
+
+static void
+SyscallFutexWait()
+{
+    int vaddr = machine->ReadRegister(4);
+    int expected = machine->ReadRegister(5);
+    int word;
+
+    if (CopyFromUser(vaddr & ~0x3, (char *)&word, 4))	// page it in
+        machine->WriteRegister(2, futexTable->Wait(vaddr, expected));
+    else
+        machine->WriteRegister(2, -1);
+}
+
+static void
+SyscallFutexWake()
+{
+    int vaddr = machine->ReadRegister(4);
+    int word;
+
+    if (CopyFromUser(vaddr & ~0x3, (char *)&word, 4))	// page it in
+        machine->WriteRegister(2, futexTable->Wake(vaddr, machine->ReadRegister(5)));
+    else
+        machine->WriteRegister(2, -1);
+}
+
+static void
+SyscallNumInstr()
+{
+    machine->WriteRegister(2, currentThread->GetInstructionCount());
+}
+
+static void
+SyscallNumPageFaults()
+{
+    machine->WriteRegister(2, currentThread->GetPageFaultCount());
+}
+
+// When ExceptionHandler advances the program counters past a system
+// call.  Calls that may block or switch threads need them advanced
+// before, so that the thread (or a fork of it) carries on after the
+// call when it next runs.
+#define AdvanceAfter	0	// once the handler returns
+#define AdvanceBefore	1	// before the handler runs
+#define AdvanceNever	2	// the handler does not return
+
+typedef void (*SyscallHandler)();
+
+class SyscallEntry {
+  public:
+    SyscallHandler handler;		// NULL if not implemented
+    const char *name;			// for Statistics::Print
+    int advance;			// AdvanceAfter, AdvanceBefore or
+					// AdvanceNever
+};
+
+#define NoSyscall	{ NULL, NULL, AdvanceNever }
+
+// Indexed by system call code; see syscall.h.
+static SyscallEntry syscallTable[MaxSyscalls] = {
+    { SyscallHalt,		"Halt",		AdvanceNever },		// 0
+    { SyscallExit,		"Exit",		AdvanceNever },		// 1
+    { SyscallExec,		"Exec",		AdvanceBefore },	// 2
+    { SyscallJoin,		"Join",		AdvanceAfter },		// 3
+    { SyscallCreate,		"Create",	AdvanceAfter },		// 4
+    { SyscallOpen,		"Open",		AdvanceAfter },		// 5
+    { SyscallRead,		"Read",		AdvanceAfter },		// 6
+    { SyscallWrite,		"Write",	AdvanceAfter },		// 7
+    { SyscallClose,		"Close",	AdvanceAfter },		// 8
+    { SyscallFork,		"Fork",		AdvanceBefore },	// 9
+    { SyscallYield,		"Yield",	AdvanceBefore },	// 10
+    { SyscallPrintInt,		"PrintInt",	AdvanceAfter },		// 11
+    { SyscallPrintChar,		"PrintChar",	AdvanceAfter },		// 12
+    { SyscallPrintString,	"PrintString",	AdvanceAfter },		// 13
+    { SyscallGetReg,		"GetReg",	AdvanceAfter },		// 14
+    { SyscallGetPA,		"GetPA",	AdvanceAfter },		// 15
+    { SyscallGetPID,		"GetPID",	AdvanceAfter },		// 16
+    { SyscallGetPPID,		"GetPPID",	AdvanceAfter },		// 17
+    { SyscallSleep,		"Sleep",	AdvanceBefore },	// 18
+    { SyscallTime,		"Time",		AdvanceAfter },		// 19
+    { SyscallPrintIntHex,	"PrintIntHex",	AdvanceAfter },		// 20
+    { SyscallSemGet,		"SemGet",	AdvanceAfter },		// 21
+    { SyscallSemOp,		"SemOp",	AdvanceBefore },	// 22
+    { SyscallSemCtl,		"SemCtl",	AdvanceAfter },		// 23
+    { SyscallCondGet,		"CondGet",	AdvanceAfter },		// 24
+    { SyscallCondOp,		"CondOp",	AdvanceBefore },	// 25
+    { SyscallCondRemove,	"CondRemove",	AdvanceAfter },		// 26
+    { SyscallShmAllocate,	"ShmAllocate",	AdvanceAfter },		// 27
+    { SyscallSbrk,		"Sbrk",		AdvanceAfter },		// 28
+    { SyscallMadvise,		"Madvise",	AdvanceAfter },		// 29
+    { SyscallFutexWait,		"FutexWait",	AdvanceBefore },	// 30
+    { SyscallFutexWake,		"FutexWake",	AdvanceAfter },		// 31
+    { SyscallSpawn,		"Spawn",	AdvanceBefore },	// 32
+    { SyscallThreadCreate,	"ThreadCreate",	AdvanceAfter },		// 33
+    NoSyscall, NoSyscall, NoSyscall, NoSyscall,			// 34-37
+    NoSyscall, NoSyscall, NoSyscall, NoSyscall, NoSyscall, NoSyscall,	// 38-43
+    NoSyscall, NoSyscall, NoSyscall, NoSyscall, NoSyscall, NoSyscall,	// 44-49
+    { SyscallNumInstr,		"NumInstr",	AdvanceAfter },		// 50
+    { SyscallNumPageFaults,	"NumPageFaults", AdvanceAfter },	// 51
+};
+
+//----------------------------------------------------------------------
+// SyscallName
+// 	The name of system call "type", for Statistics::Print; NULL if
+//	there is no such call.
+//----------------------------------------------------------------------
+
+const char *
+SyscallName(int type)
+{
+    if ((type < 0) || (type >= MaxSyscalls))
+        return NULL;
+    return syscallTable[type].name;
+}
+
+//----------------------------------------------------------------------
+// ExceptionHandler
+// 	Entry point into the Nachos kernel.  Called when a user program
+//	is executing, and either does a syscall, or generates an addressing
+//	or arithmetic exception.
+//
+// 	For system calls, the following is the calling convention:
+//
+// 	system call code -- r2
+//		arg1 -- r4
+//		arg2 -- r5
+//		arg3 -- r6
+//		arg4 -- r7
+//
+//	The result of the system call, if any, must be put back into r2.
+//
+// And don't forget to increment the pc before returning. (Or else you'll
+// loop making the same system call forever!
+//
+//	"which" is the kind of exception.  The list of possible exceptions
+//	are in machine.h.
+//----------------------------------------------------------------------
+
+void
+ExceptionHandler(ExceptionType which)
+{
+    int type = machine->ReadRegister(2);
+    SyscallEntry *entry;
+    int startTick, ticks;
+    unsigned virtAddr;          // Used by PageFaultException
+
+    if (which == SyscallException) {
+        stats->numSyscalls++;
+        // A checkpoint is taken on entry to a system call, so that the
+        // restored thread simply issues it again
+        if ((checkpointName != NULL) && (stats->totalTicks >= checkpointTick) &&
+            CheckpointIsSafe()) {
+            TakeCheckpoint(checkpointName);
+            checkpointName = NULL;
         }
-        else {
-            ConvertIntToHex (printvalus, console);
+        if (BranchIsDue() && CheckpointIsSafe())
+            Branch();			// returns in each child
+
+        if ((type < 0) || (type >= MaxSyscalls) ||
+                                (syscallTable[type].handler == NULL)) {
+            printf("Unexpected user mode exception %d %d\n", which, type);
+            ASSERT(FALSE);
         }
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SYScall_NumInstr)) {
-        machine->WriteRegister(2, currentThread->GetInstructionCount());
-        // Advance program counters.
-        machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-        machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-        machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+        entry = &syscallTable[type];
+        stats->syscallCalls[type]++;
+        startTick = stats->totalTicks;
+
+        currentThread->SetResumable(FALSE);
+        if (entry->advance == AdvanceBefore)
+            AdvancePC();
+        (*entry->handler)();
+        if (entry->advance == AdvanceAfter)
+            AdvancePC();
+        currentThread->SetResumable(TRUE);
+
+        ticks = stats->totalTicks - startTick;
+        stats->syscallTicks[type] += ticks;
+        if (ticks > stats->syscallMaxTicks[type])
+            stats->syscallMaxTicks[type] = ticks;
     } else if ((which == PageFaultException)) {
         virtAddr = (unsigned)machine->ReadRegister(39);
-        currentThread->space->PageFaultHandler(virtAddr);
+        if (!currentThread->space->PageFaultHandler(virtAddr)) {
+            // Outside the address space, or a stack overflow into the
+            // guard page
+            printf("[pid %d]: Segmentation fault at 0x%x\n", currentThread->GetPID(), virtAddr);
+            ExitCurrentProcess(-1);
+        }
         // machine->WriteRegister(2, 0);
     } else {
         printf("Unexpected user mode exception %d %d\n", which, type);
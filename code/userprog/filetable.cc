@@ -0,0 +1,207 @@
+// filetable.cc
+//	Routines to manage the open files of a user process.  See
+//	filetable.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "syscall.h"
+#include "usermem.h"
+#include "filetable.h"
+
+//----------------------------------------------------------------------
+// FileTable::FileTable
+// 	Initialize the descriptors of a new process: the console on
+//	ConsoleInput and ConsoleOutput, nothing else.
+//----------------------------------------------------------------------
+
+FileTable::FileTable()
+{
+    int fd;
+
+    for (fd = 0; fd < MaxOpenFiles; fd++)
+	files[fd] = NULL;
+    files[ConsoleInput] = new SharedFile(NULL, KeyboardFile);
+    files[ConsoleOutput] = new SharedFile(NULL, DisplayFile);
+}
+
+//----------------------------------------------------------------------
+// FileTable::FileTable
+// 	Used by fork: the child gets every open file of the parent,
+//	position included.
+//----------------------------------------------------------------------
+
+FileTable::FileTable(FileTable *parentTable)
+{
+    int fd;
+
+    for (fd = 0; fd < MaxOpenFiles; fd++) {
+	files[fd] = parentTable->files[fd];
+	if (files[fd] != NULL)
+	    files[fd]->refCount++;
+    }
+}
+
+FileTable::~FileTable()
+{
+    int fd;
+
+    for (fd = 0; fd < MaxOpenFiles; fd++)
+	Close(fd);
+}
+
+//----------------------------------------------------------------------
+// FileTable::Lookup
+// 	The open file of descriptor "fd", or NULL.
+//----------------------------------------------------------------------
+
+SharedFile *
+FileTable::Lookup(int fd)
+{
+    if ((fd < 0) || (fd >= MaxOpenFiles))
+	return NULL;
+    return files[fd];
+}
+
+//----------------------------------------------------------------------
+// FileTable::Open
+// 	Give "file" the lowest free descriptor, reading and writing
+//	from its start.  Returns -1, and leaves the file to the caller
+//	to close, if every descriptor is in use.
+//----------------------------------------------------------------------
+
+int
+FileTable::Open(OpenFile *file)
+{
+    int fd;
+
+    for (fd = 0; fd < MaxOpenFiles; fd++) {
+	if (files[fd] == NULL) {
+	    files[fd] = new SharedFile(file, DiskFile);
+	    return fd;
+	}
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FileTable::Close
+// 	Free descriptor "fd".  The file is closed once no descriptor of
+//	any process refers to it.
+//----------------------------------------------------------------------
+
+bool
+FileTable::Close(int fd)
+{
+    SharedFile *shared = Lookup(fd);
+
+    if (shared == NULL)
+	return FALSE;
+    files[fd] = NULL;
+    if (--shared->refCount == 0)
+	delete shared;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FileTable::Read
+// 	Read up to "size" bytes from descriptor "fd" into user memory at
+//	"virtAddr", a page at a time.  A DiskFile stops at its end; the
+//	keyboard waits for one character, and returns what has been
+//	typed by then.
+//----------------------------------------------------------------------
+
+int
+FileTable::Read(int fd, int virtAddr, int size)
+{
+    SharedFile *shared = Lookup(fd);
+    char *buffer;
+    int done = 0, chunk, numRead;
+
+    if ((shared == NULL) || (shared->kind == DisplayFile) || (size < 0))
+	return -1;
+
+    buffer = new char[PageSize];
+    while (done < size) {
+	chunk = size - done;
+	if (chunk > PageSize)
+	    chunk = PageSize;
+	if (shared->kind == KeyboardFile) {
+	    numRead = consoleDriver->Read(buffer, chunk);
+	} else {
+	    numRead = shared->file->ReadAt(buffer, chunk, shared->position);
+	    shared->position += numRead;
+	}
+	if (!CopyToUser(virtAddr + done, buffer, numRead)) {
+	    done = -1;
+	    break;
+	}
+	done += numRead;
+	if ((numRead < chunk) || (shared->kind == KeyboardFile))
+	    break;
+    }
+    delete [] buffer;
+    return done;
+}
+
+//----------------------------------------------------------------------
+// FileTable::Write
+// 	Write "size" bytes from user memory at "virtAddr" to descriptor
+//	"fd", a page at a time.  A DiskFile stops at a short write, and
+//	the bytes written by then are returned.
+//----------------------------------------------------------------------
+
+int
+FileTable::Write(int fd, int virtAddr, int size)
+{
+    SharedFile *shared = Lookup(fd);
+    char *buffer;
+    int done = 0, chunk, numWritten;
+
+    if ((shared == NULL) || (shared->kind == KeyboardFile) || (size < 0))
+	return -1;
+
+    buffer = new char[PageSize];
+    while (done < size) {
+	chunk = size - done;
+	if (chunk > PageSize)
+	    chunk = PageSize;
+	if (!CopyFromUser(virtAddr + done, buffer, chunk)) {
+	    done = -1;
+	    break;
+	}
+	if (shared->kind == DisplayFile) {
+	    consoleDriver->Write(buffer, chunk);
+	    numWritten = chunk;
+	} else {
+	    numWritten = shared->file->WriteAt(buffer, chunk, shared->position);
+	    shared->position += numWritten;
+	}
+	done += numWritten;
+	if (numWritten < chunk)
+	    break;
+    }
+    delete [] buffer;
+    return done;
+}
+
+//----------------------------------------------------------------------
+// FileTable::OnlyConsole
+// 	Is every open descriptor the console?  A checkpoint cannot save
+//	the host files behind disk files.
+//----------------------------------------------------------------------
+
+bool
+FileTable::OnlyConsole()
+{
+    int fd;
+
+    for (fd = 0; fd < MaxOpenFiles; fd++) {
+	if ((files[fd] != NULL) && (files[fd]->kind == DiskFile))
+	    return FALSE;
+    }
+    return TRUE;
+}
@@ -0,0 +1,83 @@
+// filetable.h
+//	Data structures for the files a user process has open: a table
+//	of descriptors, indexed by the OpenFileId the system calls take.
+//
+//	  system_call_Create(name)		make an empty file
+//	  system_call_Open(name)		a descriptor for it
+//	  system_call_Read(buffer, size, id)	bytes read, 0 at the end
+//	  system_call_Write(buffer, size, id)	bytes written
+//	  system_call_Close(id)
+//
+//	Every process starts with the console open: the keyboard on
+//	ConsoleInput (0) and the display on ConsoleOutput (1).
+//
+//	A descriptor refers to a SharedFile, which holds the position
+//	of the next Read or Write.  Fork and Spawn give the child the
+//	parent's SharedFiles, so the two move through a file together,
+//	as UNIX processes do; Exec keeps the table.
+//
+//	Read and Write move data between the file and user memory a
+//	page at a time, through a kernel buffer.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FILETABLE_H
+#define FILETABLE_H
+
+#include "copyright.h"
+#include "openfile.h"
+
+#define MaxOpenFiles	16		// descriptors per process
+
+// What a descriptor refers to
+#define DiskFile	0
+#define KeyboardFile	1
+#define DisplayFile	2
+
+// An open file, and the descriptors (of any process) that use it
+
+class SharedFile {
+  public:
+    SharedFile(OpenFile *openFile, int fileKind) { file = openFile;
+			kind = fileKind; position = 0; refCount = 1; }
+    ~SharedFile() { delete file; }
+
+    OpenFile *file;			// NULL for the console
+    int kind;				// DiskFile, KeyboardFile or
+					// DisplayFile
+    int position;			// where the next Read or Write
+					// of a DiskFile starts
+    int refCount;			// descriptors using it
+};
+
+// The descriptors of one process
+
+class FileTable {
+  public:
+    FileTable();			// Just the console open
+    FileTable(FileTable *parentTable);	// Used by fork: the same files
+    ~FileTable();			// Close every descriptor
+
+    int Open(OpenFile *file);		// Lowest free descriptor for
+					// "file", or -1 if the table is
+					// full
+    bool Close(int fd);			// FALSE if fd is not open
+
+    int Read(int fd, int virtAddr, int size);
+    int Write(int fd, int virtAddr, int size);
+					// Move data between the file and
+					// user memory; the bytes moved,
+					// or -1 on a bad descriptor or
+					// address
+
+    bool OnlyConsole();			// Is no disk file open?
+
+  private:
+    SharedFile *Lookup(int fd);		// NULL if fd is not open
+
+    SharedFile *files[MaxOpenFiles];
+};
+
+#endif // FILETABLE_H
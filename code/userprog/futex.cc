@@ -0,0 +1,136 @@
+// futex.cc
+//	Routines for waiting on words of user memory.  See futex.h.
+//
+//	The caller of Wait and Wake has already touched the word, so
+//	its page is in memory.  From there on interrupts are off, so
+//	the word cannot change, nor the page move, before the thread
+//	is on its wait queue.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "futex.h"
+
+//----------------------------------------------------------------------
+// FutexTable::FutexTable
+// 	Initialize the table, with every bucket empty.
+//----------------------------------------------------------------------
+
+FutexTable::FutexTable()
+{
+    int i;
+
+    for (i = 0; i < FutexHashSize; i++)
+	buckets[i] = NULL;
+    numWaiters = 0;
+}
+
+FutexTable::~FutexTable()
+{
+    int i;
+
+    for (i = 0; i < FutexHashSize; i++)
+	ASSERT(buckets[i] == NULL);
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wait
+// 	Put the current thread to sleep on the word at user address
+//	"virtAddr", if the word still holds "expected".  Returns 0 once
+//	woken up, or -1 straight away if the word holds something else.
+//----------------------------------------------------------------------
+
+int
+FutexTable::Wait(int virtAddr, int expected)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    FutexWaiter *waiter, **link;
+    int physAddr = machine->GetPA(virtAddr);
+
+    if ((physAddr == -1) || (virtAddr & 0x3) || ((int) WordToHost(
+		*(unsigned int *) &machine->mainMemory[physAddr]) != expected)) {
+	(void) interrupt->SetLevel(oldLevel);
+	return -1;
+    }
+
+    waiter = new FutexWaiter(physAddr, currentThread);
+    for (link = &buckets[Hash(physAddr)]; *link != NULL; link = &(*link)->next)
+	;
+    *link = waiter;
+    numWaiters++;
+    currentThread->PutThreadToSleep();		// Wake frees the waiter
+    (void) interrupt->SetLevel(oldLevel);
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::WakeMatching
+// 	Wake up to "count" threads in "bucket" that wait on a word in
+//	physical addresses [lo, hi), the longest waiting first.  Returns
+//	the number woken.  Interrupts must be off.
+//----------------------------------------------------------------------
+
+int
+FutexTable::WakeMatching(int bucket, int lo, int hi, int count)
+{
+    FutexWaiter *waiter, **link = &buckets[bucket];
+    int woken = 0;
+
+    while ((*link != NULL) && (woken < count)) {
+	waiter = *link;
+	if ((waiter->physAddr >= lo) && (waiter->physAddr < hi)) {
+	    *link = waiter->next;
+	    scheduler->ThreadIsReadyToRun(waiter->thread);
+	    delete waiter;
+	    numWaiters--;
+	    woken++;
+	} else {
+	    link = &waiter->next;
+	}
+    }
+    return woken;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wake
+// 	Wake up to "count" threads waiting on the word at user address
+//	"virtAddr".  Returns the number woken.
+//----------------------------------------------------------------------
+
+int
+FutexTable::Wake(int virtAddr, int count)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int physAddr = machine->GetPA(virtAddr);
+    int woken = 0;
+
+    if ((physAddr != -1) && (count > 0))
+	woken = WakeMatching(Hash(physAddr), physAddr, physAddr + 1, count);
+    (void) interrupt->SetLevel(oldLevel);
+    return woken;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::WakeFrame
+// 	Physical page "frame" is being given to another page, so its
+//	addresses no longer name the words the waiters on it wait on.
+//	Wake them all up, to check their words again.
+//----------------------------------------------------------------------
+
+void
+FutexTable::WakeFrame(int frame)
+{
+    IntStatus oldLevel;
+    int i;
+
+    if (numWaiters == 0)
+	return;				// the usual case, on every page fault
+    oldLevel = interrupt->SetLevel(IntOff);
+    for (i = 0; i < FutexHashSize; i++)
+	(void) WakeMatching(i, frame * PageSize, (frame + 1) * PageSize,
+			    MAX_THREAD_COUNT);
+    (void) interrupt->SetLevel(oldLevel);
+}
@@ -0,0 +1,67 @@
+// futex.h
+//	Data structures for futexes: waiting on a word of user memory
+//	until another thread says it has changed.
+//
+//	  system_call_FutexWait(addr, expected)
+//		sleep, if the word at addr still holds "expected"
+//	  system_call_FutexWake(addr, n)
+//		wake up to n threads sleeping on addr
+//
+//	A user-level lock keeps its state in the word and only traps
+//	when it has to sleep or wake someone, so taking a free lock
+//	costs no system call at all.
+//
+//	Waiters are kept by the physical address of the word, so
+//	processes that share a page (ShmAllocate) find each other
+//	whatever virtual address they use for it.  If a page with
+//	waiters loses its frame, they are all woken up: like every
+//	futex user, they must check the word again anyway.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include "copyright.h"
+#include "thread.h"
+
+#define FutexHashSize	64		// buckets of the wait queues
+
+// A thread waiting on a word
+
+class FutexWaiter {
+  public:
+    FutexWaiter(int addr, NachOSThread *th) { physAddr = addr; thread = th;
+					       next = NULL; }
+
+    int physAddr;			// the word it waits on
+    NachOSThread *thread;
+    FutexWaiter *next;			// next waiter in the same bucket
+};
+
+// All the waiters, hashed on the physical address of their word.
+// Each bucket is kept in the order the threads went to sleep.
+
+class FutexTable {
+  public:
+    FutexTable();			// Initialize with no waiters
+    ~FutexTable();			// De-allocate; no one may wait
+
+    int Wait(int virtAddr, int expected);
+					// 0 once woken, -1 if the word was
+					// not "expected" (or not mapped)
+    int Wake(int virtAddr, int count);	// Number of threads woken
+    void WakeFrame(int frame);		// The frame is getting another page
+
+  private:
+    int Hash(int physAddr) { return (physAddr >> 2) % FutexHashSize; }
+    int WakeMatching(int bucket, int lo, int hi, int count);
+					// wake waiters on [lo, hi)
+
+    FutexWaiter *buckets[FutexHashSize];
+    int numWaiters;			// in all buckets
+};
+
+#endif // FUTEX_H
@@ -10,8 +10,8 @@
 
 #include "copyright.h"
 #include "system.h"
-#include "console.h"
 #include "addrspace.h"
+#include "filetable.h"
 #include "synch.h"
 #include "filesys.h"
 
@@ -23,28 +23,67 @@ BatchStartFunction (int dummy)
 }
 
 //----------------------------------------------------------------------
-// StartUserProcess
-// 	Run a user program.  Open the executable, load it into
-//	memory, and jump to it.
+// ExecUserProcess
+// 	Replace the program of the current thread with the executable
+//	"filename", called with the "argc" strings of "argv".  The
+//	thread keeps its pid and its open files.  The new address space
+//	is built first, and only then is the old one freed, frames and
+//	swap included.  That order is safe because pages come in on
+//	demand: the new space holds no frames yet, so nothing of it can
+//	collide with the old one's frames or TLB entries.  The user
+//	registers are set to start the new program, so the caller need
+//	only return to the machine.
+//
+//	Returns FALSE, with the old program untouched, if "filename"
+//	cannot be opened.
 //----------------------------------------------------------------------
 
-void
-StartUserProcess(char *filename)
+bool
+ExecUserProcess(char *filename, int argc, char **argv)
 {
     OpenFile *executable = fileSystem->Open(filename);
-    ProcessAddrSpace *space;
+    ProcessAddrSpace *space, *oldSpace = currentThread->space;
 
     if (executable == NULL) {
 	printf("Unable to open file %s\n", filename);
-	return;
+	return FALSE;
     }
-    space = new ProcessAddrSpace(executable, filename, 0);
-    currentThread->space = space;
-
+    space = new ProcessAddrSpace(executable, filename, currentThread->GetPID());
     delete executable;    // close file
 
+    if (oldSpace != NULL) {			// Exec keeps the open files
+	int oldPid = oldSpace->pid;
+
+	delete space->files;
+	space->files = oldSpace->files;
+	oldSpace->files = NULL;
+	delete oldSpace;			// before the new space has
+						// any frames, so its TLB
+						// entries are all old ones
+	if (oldPid != currentThread->GetPID()) {	// made by a thread
+	    delete threadArray[oldPid];		// that exited, and was
+	    threadArray[oldPid] = NULL;		// kept for its frames
+	}
+    }
+    currentThread->space = space;
+
     space->InitUserCPURegisters();		// set the initial register values
     space->RestoreStateOnSwitch();		// load page table register
+    space->PushArguments(argc, argv);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// StartUserProcess
+// 	Run a user program.  Open the executable, load it into
+//	memory, and jump to it, with its name as argv[0].
+//----------------------------------------------------------------------
+
+void
+StartUserProcess(char *filename)
+{
+    if (!ExecUserProcess(filename, 1, &filename))
+	return;
 
     machine->Run();			// jump to the user progam
     ASSERT(FALSE);			// machine->Run never returns;
@@ -52,41 +91,22 @@ StartUserProcess(char *filename)
 					// by doing the syscall "exit"
 }
 
-// Data structures needed for the console test.  Threads making
-// I/O requests wait on a Semaphore to delay until the I/O completes.
-
-static Console *console;
-static Semaphore *readAvail;
-static Semaphore *writeDone;
-
-//----------------------------------------------------------------------
-// ConsoleInterruptHandlers
-// 	Wake up the thread that requested the I/O.
-//----------------------------------------------------------------------
-
-static void ReadAvail(int arg) { readAvail->V(); }
-static void WriteDone(int arg) { writeDone->V(); }
-
 //----------------------------------------------------------------------
 // ConsoleTest
 // 	Test the console by echoing characters typed at the input onto
-//	the output.  Stop when the user types a 'q'.
+//	the output.  Stop when the user types a 'q'.  The console is
+//	the one consoleDriver opened at boot (on the files given to -c,
+//	if any), so nothing else reads the same terminal.
 //----------------------------------------------------------------------
 
 void
-ConsoleTest (char *in, char *out)
+ConsoleTest ()
 {
     char ch;
 
-    console = new Console(in, out, ReadAvail, WriteDone, 0);
-    readAvail = new Semaphore("read avail", 0);
-    writeDone = new Semaphore("write done", 0);
-
     for (;;) {
-	readAvail->P();		// wait for character to arrive
-	ch = console->GetChar();
-	console->PutChar(ch);	// echo it!
-	writeDone->P() ;        // wait for write to finish
+	ch = consoleDriver->GetChar();	// wait for character to arrive
+	consoleDriver->PutChar(ch);	// echo it, and wait for the write
 	if (ch == 'q') return;  // if q, quit
     }
 }
@@ -49,7 +49,14 @@
 #define SYScall_CondOp		25
 #define SYScall_CondRemove	26
 #define SYScall_ShmAllocate	27
+#define SYScall_Sbrk		28
+#define SYScall_Madvise		29
+#define SYScall_FutexWait	30
+#define SYScall_FutexWake	31
+#define SYScall_Spawn		32
+#define SYScall_ThreadCreate	33
 #define SYScall_NumInstr        50
+#define SYScall_NumPageFaults	51
 
 #ifndef IN_ASM
 
@@ -76,9 +83,19 @@ void system_call_Exit(int status);
 /* This is same as PID. */
 typedef int SpaceId;	
  
-/* Run the executable, stored in the Nachos file "name". Doesn't return.
+/* Run the executable, stored in the Nachos file "name", in place of
+ * this program: the pid and the open files are kept.  "argv" is a NULL
+ * terminated array of at most 16 strings, handed to the new program's
+ * main(argc, argv); a NULL argv passes just "name".  Doesn't return,
+ * unless the executable or the arguments cannot be read: then -1.
  */
-void system_call_Exec(char *name);
+int system_call_Exec(char *name, char **argv);
+
+/* Start the executable "name" as a new child, called with "argv" as
+ * for Exec, without copying this program first.  The child shares the
+ * open files, as after Fork.  Returns the child's pid, or -1.
+ */
+SpaceId system_call_Spawn(char *name, char **argv);
  
 /* Only return once the the user program "id" has finished.  
  * Return the exit status.
@@ -107,16 +124,22 @@ typedef int OpenFileId;
 #define ConsoleInput	0  
 #define ConsoleOutput	1  
  
-/* Create a Nachos file, with "name" */
-void system_call_Create(char *name);
+/* Create an empty Nachos file, with "name".  Returns 0, or -1 if it
+ * cannot be created.
+ */
+int system_call_Create(char *name);
 
 /* Open the Nachos file "name", and return an "OpenFileId" that can 
- * be used to read and write to the file.
+ * be used to read and write to the file, or -1 if it cannot be opened.
+ * A forked child shares its parent's open files, and the position
+ * in them.
  */
 OpenFileId system_call_Open(char *name);
 
-/* Write "size" bytes from "buffer" to the open file. */
-void system_call_Write(char *buffer, int size, OpenFileId id);
+/* Write "size" bytes from "buffer" to the open file.  Returns the
+ * number written, or -1 on a bad id or buffer.
+ */
+int system_call_Write(char *buffer, int size, OpenFileId id);
 
 /* Read "size" bytes from the open file into "buffer".  
  * Return the number of bytes actually read -- if the open file isn't
@@ -126,8 +149,10 @@ void system_call_Write(char *buffer, int size, OpenFileId id);
  */
 int system_call_Read(char *buffer, int size, OpenFileId id);
 
-/* Close the file, we're done reading and writing to it. */
-void system_call_Close(OpenFileId id);
+/* Close the file, we're done reading and writing to it.  Returns 0,
+ * or -1 if "id" was not open.
+ */
+int system_call_Close(OpenFileId id);
 
 
 
@@ -144,6 +169,14 @@ int system_call_Fork();
  */
 void system_call_Yield();		
 
+/* Run func(arg) in a new thread of this program: it shares the memory
+ * and the open files, on a stack of its own taken from the heap.  The
+ * thread exits, with func's return value, when func returns or calls
+ * system_call_Exit.  Returns its pid, to give to system_call_Join, or
+ * -1.  A program cannot Exec while its threads run.
+ */
+int system_call_ThreadCreate(int (*func)(int), int arg);
+
 // New definitions
 
 void system_call_PrintInt (int x);
@@ -166,14 +199,25 @@ void system_call_Sleep (unsigned);
 
 int system_call_GetTime (void);
 
-int systm_SemGet (int key);
+/* Semaphores and condition variables shared by key; see synchop.h
+ * for the commands and ops.  A new semaphore starts at 0.  The Get
+ * calls return an id, or -1 if there are too many; the others return
+ * 0, or -1 on a bad id or command, or on removing an object that
+ * someone is waiting on.
+ */
+int system_call_SemGet (int key);
 
+/* adjust is -1 (P) or +1 (V) */
 void system_call_SemOp (int semid, int adjust);
 
+/* SYNCH_REMOVE, or SYNCH_GET / SYNCH_SET the value in *val */
 int system_call_SemCtl (int semid, unsigned command, int *val);
 
 int system_call_CondGet (int key);
 
+/* COND_OP_WAIT (semid is the mutex, held), COND_OP_SIGNAL or
+ * COND_OP_BROADCAST
+ */
 void system_call_CondOp (int condid, unsigned op, int semid);
 
 int system_call_CondRemove (int condid);
@@ -181,6 +225,43 @@ int system_call_CondRemove (int condid);
 unsigned system_call_ShmAllocate (unsigned size);
 
 int system_call_GetNumInstr (void);
+
+/* Grow the heap by "increment" bytes.  Returns the old end of the heap,
+ * which is the start of the new bytes, or -1 if the heap is full.
+ * The new memory reads as zero.
+ */
+int system_call_Sbrk (int increment);
+
+/* Number of page faults taken so far by the calling thread */
+int system_call_GetNumPageFaults (void);
+
+/* Hints for system_call_Madvise */
+#define MADV_NORMAL	0	/* no special treatment (the default) */
+#define MADV_WILLNEED	1	/* bring the pages in now */
+#define MADV_DONTNEED	2	/* drop the pages; they read as zero, or
+				 * as the executable, when touched again */
+#define MADV_SEQUENTIAL	3	/* read ahead on faults, drop behind */
+#define MADV_RANDOM	4	/* never read ahead, not even as a large page */
+#define MADV_LOCK	5	/* bring the pages in and keep them resident */
+#define MADV_UNLOCK	6	/* undo MADV_LOCK */
+
+/* Tell the VM how the "size" bytes starting at "addr" will be used.
+ * The whole range must be mapped.  Returns 0, or -1 on a bad range or
+ * hint, or if locking would pin too much of physical memory.
+ */
+int system_call_Madvise (unsigned addr, unsigned size, int advice);
+
+/* Sleep until woken by system_call_FutexWake on "addr", if the word
+ * at "addr" still holds "expected".  Returns 0 once woken, or -1 at
+ * once if the word holds something else.  Wakeups can be spurious, so
+ * check the word again.
+ */
+int system_call_FutexWait (int *addr, int expected);
+
+/* Wake up to "count" threads waiting on "addr", in any process that
+ * shares its page.  Returns the number woken.
+ */
+int system_call_FutexWake (int *addr, int count);
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
@@ -0,0 +1,183 @@
+// usermem.cc
+//	Routines to copy between user memory and the kernel.  See
+//	usermem.h.
+//
+//	Translations are made through the machine, like the user
+//	program's own loads and stores, so use and dirty bits, TLB
+//	counts and the reference bits of the replacement policy all see
+//	the copy.  The data cache model does not: the kernel's own
+//	accesses never go through it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "usermem.h"
+
+//----------------------------------------------------------------------
+// TranslateUser
+// 	Find the physical address of "virtAddr" in the current address
+//	space, faulting its page in as often as it takes.  Returns FALSE
+//	if the address is not part of the address space, or "writing"
+//	to a read-only page.
+//----------------------------------------------------------------------
+
+static bool
+TranslateUser(int virtAddr, bool writing, int *physAddr)
+{
+    ExceptionType exception;
+
+    // A page brought in may be taken away again while this thread
+    // waits for the next one, so translate until it is there
+    while ((exception = machine->Translate(virtAddr, physAddr, 1, writing))
+						== PageFaultException) {
+	if (!currentThread->space->PageFaultHandler(virtAddr))
+	    return FALSE;
+    }
+    return (exception == NoException);
+}
+
+//----------------------------------------------------------------------
+// SpanInPage
+// 	How many of "size" bytes from "virtAddr" lie in its page.
+//----------------------------------------------------------------------
+
+static int
+SpanInPage(int virtAddr, int size)
+{
+    int span = PageSize - (unsigned) virtAddr % PageSize;
+
+    return (span < size) ? span : size;
+}
+
+//----------------------------------------------------------------------
+// CopyFromUser
+// 	Copy "size" bytes at "virtAddr" in the current address space
+//	into the kernel buffer "into".  Returns FALSE if part of the
+//	range is not in the address space; "into" may then hold some of
+//	the bytes.
+//----------------------------------------------------------------------
+
+bool
+CopyFromUser(int virtAddr, char *into, int size)
+{
+    int physAddr, span;
+
+    while (size > 0) {
+	if (!TranslateUser(virtAddr, FALSE, &physAddr))
+	    return FALSE;
+	span = SpanInPage(virtAddr, size);
+	bcopy(&machine->mainMemory[physAddr], into, span);
+	virtAddr += span;
+	into += span;
+	size -= span;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// CopyToUser
+// 	Copy "size" bytes from the kernel buffer "from" to "virtAddr" in
+//	the current address space.  Returns FALSE if part of the range
+//	is not in the address space or is read-only.
+//
+//	A store by the kernel breaks an LL link into the page, as a
+//	store by any other processor would.
+//----------------------------------------------------------------------
+
+bool
+CopyToUser(int virtAddr, char *from, int size)
+{
+    int physAddr, span;
+
+    while (size > 0) {
+	if (!TranslateUser(virtAddr, TRUE, &physAddr))
+	    return FALSE;
+	span = SpanInPage(virtAddr, size);
+	machine->BreakLinkToFrame(physAddr / PageSize);
+	bcopy(from, &machine->mainMemory[physAddr], span);
+	virtAddr += span;
+	from += span;
+	size -= span;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// CopyStringFromUser
+// 	Copy the '\0' terminated string at "virtAddr" in the current
+//	address space into "into", which holds "maxSize" bytes.  Returns
+//	the length of the string, or -1 if it runs out of the address
+//	space.  A string that does not fit fills "into", with no '\0',
+//	and maxSize is returned; the caller may copy the rest from
+//	virtAddr + maxSize.
+//----------------------------------------------------------------------
+
+int
+CopyStringFromUser(int virtAddr, char *into, int maxSize)
+{
+    int physAddr, span, length = 0;
+    char *end;
+
+    while (length < maxSize) {
+	if (!TranslateUser(virtAddr + length, FALSE, &physAddr))
+	    return -1;
+	span = SpanInPage(virtAddr + length, maxSize - length);
+	bcopy(&machine->mainMemory[physAddr], into + length, span);
+	end = (char *) memchr(into + length, '\0', span);
+	if (end != NULL)
+	    return (end - into);
+	length += span;
+    }
+    return maxSize;
+}
+
+//----------------------------------------------------------------------
+// CopyArgsFromUser
+// 	Copy the NULL terminated array of strings at "virtAddr" in the
+//	current address space (an argv) into "args", which holds
+//	"maxArgs" pointers.  Each string is copied into a new array, to
+//	be freed with DeleteArgs.  Returns the number of strings, or -1,
+//	with nothing left allocated, on a bad address, a string of
+//	MaxUserString bytes or more, or more than maxArgs strings.
+//----------------------------------------------------------------------
+
+int
+CopyArgsFromUser(int virtAddr, char **args, int maxArgs)
+{
+    char buffer[MaxUserString];
+    int argc, argAddr, length;
+
+    for (argc = 0; argc <= maxArgs; argc++) {
+	if (!CopyFromUser(virtAddr + argc * 4, (char *) &argAddr, 4))
+	    break;
+	argAddr = WordToHost(argAddr);
+	if (argAddr == 0)
+	    return argc;
+	if (argc == maxArgs)
+	    break;
+	length = CopyStringFromUser(argAddr, buffer, MaxUserString);
+	if ((length == -1) || (length == MaxUserString))
+	    break;
+	args[argc] = new char[length + 1];
+	bcopy(buffer, args[argc], length + 1);
+    }
+    DeleteArgs(args, argc);
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// DeleteArgs
+// 	Free the "argc" strings CopyArgsFromUser put in "args".
+//----------------------------------------------------------------------
+
+void
+DeleteArgs(char **args, int argc)
+{
+    int i;
+
+    for (i = 0; i < argc; i++)
+	delete [] args[i];
+}
@@ -0,0 +1,48 @@
+// usermem.h
+//	Routines for the system calls to copy strings and buffers
+//	between user memory and the kernel.
+//
+//	Each page of the user range is translated once, and the part of
+//	the copy that falls in it is moved with one bcopy, rather than
+//	a ReadMem or WriteMem per byte.  A page that is not in memory
+//	(or, with a TLB, not in the TLB) is brought in by the address
+//	space's PageFaultHandler, and the page tried again.
+//
+//	An address outside the address space, or a write to a read-only
+//	page, fails the copy: the system call gets -1 back rather than
+//	the process being killed.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef USERMEM_H
+#define USERMEM_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define MaxUserString	1024		// longest string a system call
+					// takes in, with its '\0'
+#define MaxUserArgs	16		// most strings in an argv
+
+extern bool CopyFromUser(int virtAddr, char *into, int size);
+					// Copy "size" bytes in from user
+					// memory; FALSE on a bad address
+extern bool CopyToUser(int virtAddr, char *from, int size);
+					// Copy "size" bytes out to user
+					// memory
+extern int CopyStringFromUser(int virtAddr, char *into, int maxSize);
+					// Copy in a '\0' terminated string;
+					// returns its length, maxSize if
+					// it is longer (the first maxSize
+					// bytes are copied), or -1 on a
+					// bad address
+extern int CopyArgsFromUser(int virtAddr, char **args, int maxArgs);
+					// Copy in a NULL terminated array
+					// of strings, each into a new
+					// array; returns how many, or -1
+extern void DeleteArgs(char **args, int argc);
+					// Free what CopyArgsFromUser made
+
+#endif // USERMEM_H
@@ -0,0 +1,190 @@
+// usersynch.cc
+//	Routines for the semaphores and condition variables of user
+//	programs.  See usersynch.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "usersynch.h"
+
+//----------------------------------------------------------------------
+// UserSynchTable::UserSynchTable
+// 	Initialize an empty table; every slot is on the free list.
+//----------------------------------------------------------------------
+
+UserSynchTable::UserSynchTable()
+{
+    int i;
+
+    for (i = 0; i < MaxUserSynchs; i++) {
+	objects[i] = NULL;
+	next[i] = i + 1;
+    }
+    next[MaxUserSynchs - 1] = -1;
+    for (i = 0; i < SynchHashSize; i++)
+	buckets[i] = -1;
+    freeSlots = 0;
+    numObjects = 0;
+}
+
+UserSynchTable::~UserSynchTable()
+{
+}
+
+//----------------------------------------------------------------------
+// UserSynchTable::Hash
+// 	The bucket of "key".  Keys are often small and consecutive, so
+//	they are mixed before taking the low bits.
+//----------------------------------------------------------------------
+
+int
+UserSynchTable::Hash(int key)
+{
+    return (((unsigned) key * 2654435761u) >> 16) % SynchHashSize;
+}
+
+//----------------------------------------------------------------------
+// UserSynchTable::Find
+// 	Return the id of the object with "key", or -1 if there is none.
+//----------------------------------------------------------------------
+
+int
+UserSynchTable::Find(int key)
+{
+    int slot;
+
+    for (slot = buckets[Hash(key)]; slot != -1; slot = next[slot])
+	if (keys[slot] == key)
+	    return slot;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// UserSynchTable::Add
+// 	Enter "object" under "key", which must not be in the table.
+//	Returns its id, or -1 if the table is full.
+//----------------------------------------------------------------------
+
+int
+UserSynchTable::Add(int key, void *object)
+{
+    int slot = freeSlots, bucket = Hash(key);
+
+    ASSERT(Find(key) == -1);
+    if (slot == -1)
+	return -1;
+    freeSlots = next[slot];
+    objects[slot] = object;
+    keys[slot] = key;
+    next[slot] = buckets[bucket];
+    buckets[bucket] = slot;
+    numObjects++;
+    return slot;
+}
+
+//----------------------------------------------------------------------
+// UserSynchTable::Lookup
+// 	Return the object with "id", or NULL if there is none -- the id
+//	comes from a user program, so it has to be checked.
+//----------------------------------------------------------------------
+
+void *
+UserSynchTable::Lookup(int id)
+{
+    if ((id < 0) || (id >= MaxUserSynchs))
+	return NULL;
+    return objects[id];
+}
+
+//----------------------------------------------------------------------
+// UserSynchTable::Remove
+// 	Take the object with "id" out of the table, and free its slot.
+//----------------------------------------------------------------------
+
+void
+UserSynchTable::Remove(int id)
+{
+    int *link;
+
+    ASSERT(Lookup(id) != NULL);
+    for (link = &buckets[Hash(keys[id])]; *link != id; link = &next[*link])
+	ASSERT(*link != -1);
+    *link = next[id];
+    objects[id] = NULL;
+    next[id] = freeSlots;
+    freeSlots = id;
+    numObjects--;
+}
+
+//----------------------------------------------------------------------
+// UserCondition::UserCondition
+// 	Initialize a condition variable, with no one waiting on it.
+//----------------------------------------------------------------------
+
+UserCondition::UserCondition(char* debugName)
+{
+    name = debugName;
+    queue = new List;
+}
+
+UserCondition::~UserCondition()
+{
+    ASSERT(queue->IsEmpty());
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// UserCondition::Wait
+// 	Give up "mutex" and sleep until signaled, then take the mutex
+//	again.  With interrupts off, no Signal can slip in between.
+//----------------------------------------------------------------------
+
+void
+UserCondition::Wait(Semaphore *mutex)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    queue->Append((void *)currentThread);
+    mutex->V();
+    currentThread->PutThreadToSleep();
+    mutex->P();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// UserCondition::Signal
+// 	Wake up the thread that has waited longest, if any.
+//----------------------------------------------------------------------
+
+void
+UserCondition::Signal()
+{
+    NachOSThread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    thread = (NachOSThread *)queue->Remove();
+    if (thread != NULL)
+	scheduler->ThreadIsReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// UserCondition::Broadcast
+// 	Wake up every waiter, in one pass with interrupts off, so that
+//	none of them can run (and come back to wait) before all of them
+//	are ready.
+//----------------------------------------------------------------------
+
+void
+UserCondition::Broadcast()
+{
+    NachOSThread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    while ((thread = (NachOSThread *)queue->Remove()) != NULL)
+	scheduler->ThreadIsReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
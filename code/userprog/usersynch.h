@@ -0,0 +1,83 @@
+// usersynch.h
+//	Data structures for the semaphores and condition variables that
+//	user programs share through system calls:
+//
+//	  id = system_call_SemGet(key)		 the semaphore named "key"
+//	  system_call_SemOp(id, -1 or +1)	 P or V
+//	  system_call_SemCtl(id, SYNCH_..., &val) remove, get or set
+//	  id = system_call_CondGet(key)		 the condition named "key"
+//	  system_call_CondOp(id, COND_OP_..., semid)
+//						 wait (using semaphore
+//						 semid as the mutex),
+//						 signal or broadcast
+//	  system_call_CondRemove(id)
+//
+//	Every process that asks for a key gets the same object, created
+//	on first use; a semaphore starts at 0.  Keys are found through a
+//	hash table, and an id is the object's slot, so each operation
+//	finds its object in constant time.  An object that a thread is
+//	waiting on cannot be removed.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef USERSYNCH_H
+#define USERSYNCH_H
+
+#include "copyright.h"
+#include "synch.h"
+
+#define MaxUserSynchs	256		// objects of one kind at a time
+#define SynchHashSize	64		// buckets of the key table
+
+// The objects of one kind (semaphores or conditions), by key and id
+
+class UserSynchTable {
+  public:
+    UserSynchTable();			// Initialize an empty table
+    ~UserSynchTable();			// De-allocate the table; the
+					// objects are the caller's
+
+    int Find(int key);			// Id of "key", or -1
+    int Add(int key, void *object);	// Enter a new object; returns
+					// its id, or -1 if the table is full
+    void *Lookup(int id);		// The object, NULL for a bad id
+    void Remove(int id);		// Take the object out of the table
+
+    bool IsEmpty() { return (numObjects == 0); }
+
+  private:
+    int Hash(int key);
+
+    void *objects[MaxUserSynchs];	// object in each slot, or NULL
+    int keys[MaxUserSynchs];		// its key
+    int next[MaxUserSynchs];		// next slot in the same bucket,
+					// or in the free list; -1 ends
+    int buckets[SynchHashSize];		// first slot of each bucket
+    int freeSlots;			// first unused slot
+    int numObjects;
+};
+
+// A condition variable for user programs.  Its mutex is a semaphore
+// (used as a binary semaphore) rather than a Lock, since that is what
+// user programs can get hold of.  Mesa semantics, as for Condition.
+
+class UserCondition {
+  public:
+    UserCondition(char* debugName);	// Initialize with no one waiting
+    ~UserCondition();			// De-allocate; no one may wait
+
+    bool hasWaiters() { return !queue->IsEmpty(); }
+
+    void Wait(Semaphore *mutex);	// V the mutex and sleep, atomically;
+					// then P it again
+    void Signal();			// Wake up the longest waiter
+    void Broadcast();			// Wake up all waiters at once
+
+  private:
+    char* name;
+    List *queue;			// threads waiting in Wait, in order
+};
+
+#endif // USERSYNCH_H
@@ -0,0 +1,160 @@
+// tlb.cc
+//	Routines for the kernel's management of a software-loaded TLB.
+//	See tlb.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "tlb.h"
+
+//----------------------------------------------------------------------
+// TLBManager::TLBManager
+// 	Set up the replacement state for the machine's TLB.
+//----------------------------------------------------------------------
+
+TLBManager::TLBManager(int _policy)
+{
+    int i, numSets = tlbSize / tlbWays;
+
+    ASSERT((_policy >= TLB_LRU_REPL) && (_policy <= TLB_RANDOM_REPL));
+    policy = _policy;
+    fifoNext = new int[numSets];
+    for (i = 0; i < numSets; i++)
+        fifoNext[i] = 0;
+}
+
+TLBManager::~TLBManager()
+{
+    delete [] fifoNext;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::ChooseVictim
+// 	Pick the entry of the set starting at "set" to replace: an
+//	invalid one if there is one, otherwise per the policy.
+//----------------------------------------------------------------------
+
+int
+TLBManager::ChooseVictim(int set)
+{
+    int i, victim;
+
+    for (i = set; i < set + tlbWays; i++) {
+        if (!machine->tlb[i].valid)
+            return i;
+    }
+
+    switch (policy) {
+        case TLB_LRU_REPL:
+            victim = set;
+            for (i = set + 1; i < set + tlbWays; i++) {
+                if (machine->tlbLastUsed[i] < machine->tlbLastUsed[victim])
+                    victim = i;
+            }
+            break;
+        case TLB_FIFO_REPL:
+            victim = set + fifoNext[set / tlbWays];
+            fifoNext[set / tlbWays] = (fifoNext[set / tlbWays] + 1) % tlbWays;
+            break;
+        default:
+            victim = set + Random() % tlbWays;
+            break;
+    }
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::WriteBackEntry
+// 	Copy the use and dirty bits of a TLB entry into the page table
+//	entry it was loaded from.
+//----------------------------------------------------------------------
+
+void
+TLBManager::WriteBackEntry(TranslationEntry *tlbEntry)
+{
+    TranslationEntry *entry;
+
+    if (!tlbEntry->valid || (threadArray[tlbEntry->asid] == NULL))
+        return;
+    entry = threadArray[tlbEntry->asid]->space->GetEntry(tlbEntry->virtualPage);
+    if ((entry != NULL) && entry->valid &&
+        (entry->physicalPage == tlbEntry->physicalPage)) {
+        entry->use = entry->use || tlbEntry->use;
+        entry->dirty = entry->dirty || tlbEntry->dirty;
+    }
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Refill
+// 	Handle a TLB miss on a page that is in memory: write back the
+//	entry being replaced, and load a copy of "entry" tagged with
+//	"asid".  A large page goes in the set of its first page.
+//----------------------------------------------------------------------
+
+void
+TLBManager::Refill(int asid, TranslationEntry *entry)
+{
+    int victim = ChooseVictim(machine->TLBSetOf(entry->virtualPage));
+
+    WriteBackEntry(&machine->tlb[victim]);
+
+    machine->tlb[victim] = *entry;
+    machine->tlb[victim].asid = asid;
+    machine->tlb[victim].use = FALSE;
+    machine->tlb[victim].dirty = FALSE;
+    machine->tlbLastUsed[victim] = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::InvalidatePage
+// 	The kernel is about to change the mapping of vpn in address
+//	space "asid".  Write back and drop its TLB entry, if any, from
+//	the TLB of every CPU.
+//----------------------------------------------------------------------
+
+void
+TLBManager::InvalidatePage(int asid, unsigned vpn)
+{
+    TranslationEntry *tlb;
+    int cpu, i;
+
+    for (cpu = 0; cpu < machine->numTLBs; cpu++) {
+        tlb = machine->cpuTLB[cpu];
+        for (i = 0; i < tlbSize; i++) {
+            if (tlb[i].valid && (tlb[i].asid == asid) &&
+                (tlb[i].virtualPage == (int) vpn)) {
+                WriteBackEntry(&tlb[i]);
+                tlb[i].valid = FALSE;
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// TLBManager::WriteBack
+// 	Bring the page table of address space "asid" up to date with
+//	the TLBs.  If "invalidate", also drop its entries (on exit).
+//----------------------------------------------------------------------
+
+void
+TLBManager::WriteBack(int asid, bool invalidate)
+{
+    TranslationEntry *tlb;
+    int cpu, i;
+
+    for (cpu = 0; cpu < machine->numTLBs; cpu++) {
+        tlb = machine->cpuTLB[cpu];
+        for (i = 0; i < tlbSize; i++) {
+            if (tlb[i].valid && (tlb[i].asid == asid)) {
+                WriteBackEntry(&tlb[i]);
+                if (invalidate)
+                    tlb[i].valid = FALSE;
+                else
+                    tlb[i].use = tlb[i].dirty = FALSE;
+            }
+        }
+    }
+}
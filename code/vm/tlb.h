@@ -0,0 +1,58 @@
+// tlb.h
+//	Data structures for the kernel's management of a software-loaded
+//	TLB.
+//
+//	The hardware (machine/translate.cc) only looks entries up; on a
+//	miss it traps with a PageFaultException.  The kernel then finds
+//	the translation in the address space's page table and loads a
+//	copy into the TLB, choosing which entry of the set to replace.
+//
+//	Entries are tagged with the pid of their address space, so they
+//	survive context switches.  Because the TLB holds copies, the use
+//	and dirty bits the hardware sets there have to be written back
+//	to the page table before the kernel relies on them: when an
+//	entry is replaced, when its page is evicted or dropped, when the
+//	space is forked, and when it exits.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TLBMANAGER_H
+#define TLBMANAGER_H
+
+#include "copyright.h"
+#include "translate.h"
+
+// TLB replacement policies, used with the -tlbrepl flag
+#define TLB_LRU_REPL	0
+#define TLB_FIFO_REPL	1
+#define TLB_RANDOM_REPL	2
+
+class TLBManager {
+  public:
+    TLBManager(int policy);		// policy is one of the above
+    ~TLBManager();
+
+    void Refill(int asid, TranslationEntry *entry);
+					// Load a copy of a page table
+					// entry, on a TLB miss
+    void InvalidatePage(int asid, unsigned vpn);
+					// Write back and drop the entry
+					// for vpn, if there is one
+    void WriteBack(int asid, bool invalidate);
+					// Write back every entry of asid,
+					// dropping them if "invalidate"
+
+  private:
+    int ChooseVictim(int set);		// Entry of the set to replace
+    void WriteBackEntry(TranslationEntry *tlbEntry);
+					// Merge its use/dirty bits into
+					// its page table entry
+
+    int policy;
+    int *fifoNext;			// Next entry to replace in each
+					// set, for TLB_FIFO_REPL
+};
+
+#endif // TLBMANAGER_H